@@ -1,168 +1,377 @@
-#include "board.hpp"
-#include "hash_table.hpp"
-#include <chrono>
+#include "solver.hpp"
+#include "opening_book.hpp"
+#include "endgame_table.hpp"
+#include "position_record.hpp"
+#include "stream_io.hpp"
+#include <future>
 #include <iostream>
-#include <limits>
-
-namespace GameSolver {
-    namespace Connect4 {
-
-        /**
-        * Connect4Solver class is responsible for solving the Connect 4 game using the Negamax algorithm.
-        */
-        class Connect4Solver {
-        private:
-            unsigned long long exploredNodeCount = 0;  // Counter for the number of nodes explored
-            std::chrono::steady_clock::duration timeLimit;  // Time limit for the solver
-            int depthLimit;  // Depth limit for the solver
-
-            /**
-            * Implementation of the Negamax algorithm with alpha-beta pruning.
-            */
-            int negamax(const Position &currentPosition, int depth, int alpha, int beta,
-                        std::chrono::steady_clock::time_point startTime, TranspositionTable &transTable);
-
-            // Function to avoid losing moves
-            bool isLosingMove(const Position &position, int move);
-
-        public:
-            /**
-            * Constructor for Connect4Solver.
-            * @param timeLimit The time limit for the solver.
-            * @param depthLimit The depth limit for the solver.
-            */
-            explicit Connect4Solver(std::chrono::steady_clock::duration timeLimit = std::chrono::steady_clock::duration::max(),
-                                    int depthLimit = std::numeric_limits<int>::max())
-                    : timeLimit(timeLimit), depthLimit(depthLimit) {}
-
-            /**
-             * Solves the Connect 4 game for the given initial position.
-             * @param initialPosition The initial position of the game.
-             * @return The score of the best move.
-             */
-            int solve(const Position &initialPosition);
-
-            /**
-             * Gets the count of explored nodes during the solving process.
-             * @return The count of explored nodes.
-             */
-            unsigned long long getExploredNodeCount() const {
-                return exploredNodeCount;
-            }
-        };
-
-        bool Connect4Solver::isLosingMove(const Position &position, int move) {
-            Position nextPosition(position);
-            nextPosition.play(move);
-
-            // Check if the move leads to a losing position
-            for (int col = 0; col < Position::WIDTH; ++col) {
-                if (nextPosition.canPlay(col)) {
-                    Position opponentPosition(nextPosition);
-                    opponentPosition.play(col);
-
-                    // If the opponent can win on their next move, this is a losing move
-                    if (opponentPosition.isWinningMove(col)) {
-                        return true;
-                    }
-                }
-            }
-
-            return false;
-        }
-
-    } // namespace Connect4
-} // namespace GameSolver
+#include <memory>
+#include <string>
+#include <vector>
 
 using namespace GameSolver::Connect4;
 
-int Connect4Solver::negamax(const Position &currentPosition, int depth, int alpha, int beta, std::chrono::steady_clock::time_point startTime, TranspositionTable &transTable) {
-    exploredNodeCount++;
+/**
+ * Options of the command line.
+ */
+struct Options {
+    bool nullWindow = false;  // Use the bisection driver instead of iterative deepening
+    bool batch = false;  // Solve many lines in parallel, one position per thread
+    unsigned int threadCount = 1;  // Search threads sharing the TranspositionTable
+    size_t memoryLimit = BasicSolver<Position>::DEFAULT_MEMORY_LIMIT;  // Bytes reserved for the TranspositionTable
+    bool stats = false;  // Report the usage of the TranspositionTable and the profile of the searches on the standard error once done
+    bool verbose = false;  // Report each iteration of the searches on the standard error
+    bool binaryInput = false;  // Read a position file instead of move sequences, see PositionRecord
+    bool binaryOutput = false;  // Write a position file of the scores instead of lines
+    const OpeningBook *book = nullptr;
+    const EndgameTable *endgameTable = nullptr;  // Only used on the standard board
+    const char *cacheFile = nullptr;  // Results of the searches loaded at start if present and saved once done
+    const char *warmCacheFile = nullptr;  // Results of the searches mapped read-only, shared with other processes
+};
+
+static void reportInvalidLine(size_t lineNumber, unsigned int move, const char *line, size_t length) {
+    std::cerr << "Line " << lineNumber << ": Invalid move " << move << " \"";
+    std::cerr.write(line, length) << "\"\n";
+}
 
-    // Use the TranspositionTable in the initial position
-    uint8_t ttEntry = transTable.get(currentPosition.key());
-    if (ttEntry != 0) {
-        return (currentPosition.nbMoves() - ttEntry);  // Return the stored score from the transposition table
+static void flushOutput(void *output) {
+    static_cast<BufferedWriter*>(output)->flush();
+}
+
+/**
+ * Reads the positions to solve on the standard input, from lines of move sequences or from the records of a
+ * position file. Invalid lines and records are reported on the standard error and skipped.
+ */
+template<class P>
+class PositionSource {
+public:
+    PositionSource(bool binary, BufferedWriter &output)
+            : lines{binary ? nullptr : new LineReader(STDIN_FILENO, flushOutput, &output)},
+              records{binary ? new PositionRecordReader<P>(STDIN_FILENO, flushOutput, &output) : nullptr}, number{0} {}
+
+    /**
+     * @return false if the input is not a position file of the board while one is expected.
+     */
+    bool isValid() const {
+        return !records || records->isValid();
     }
 
-    if (depth == 0 || currentPosition.nbMoves() >= Position::WIDTH * Position::HEIGHT) {
-        return currentPosition.nbMoves(); // Use the number of moves as a score
+    /**
+     * Gets the next valid position.
+     * @param moves: set to the move sequence of the position, found from the key for records and valid until the next call.
+     * @param length: set to the number of moves of the sequence.
+     * @return false once the input is exhausted or cannot be read.
+     */
+    bool next(P &position, const char *&moves, size_t &length) {
+        for (;;) {
+            number++;
+            if (lines) {
+                if (!lines->next(moves, length)) {
+                    return false;
+                }
+                position = P();
+                if (position.play(moves, length) == length) {
+                    return true;
+                }
+                reportInvalidLine(number, position.nbMoves() + 1, moves, length);
+            } else {
+                uint64_t packed;
+                if (!records->next(packed)) {
+                    return false;
+                }
+                PositionRecord<P> record;
+                if (record.unpack(packed) && record.position.moveSequence(sequence)) {
+                    position = record.position;
+                    moves = sequence.data();
+                    length = sequence.size();
+                    return true;
+                }
+                std::cerr << "Record " << number << ": Invalid position\n";
+            }
+        }
     }
 
-    auto endTime = getCurrentTime();
-    if (endTime - startTime >= timeLimit) {
-        return 0; // Time's up, return a neutral score
+private:
+    std::unique_ptr<LineReader> lines;  // Input of move sequences, or nullptr
+    std::unique_ptr<PositionRecordReader<P>> records;  // Input of records, or nullptr
+    size_t number;  // Number of the last line or record read
+    std::string sequence;  // Move sequence of the last record
+};
+
+/**
+ * Writes the results of the positions on the standard output: lines of their move sequence, score and number
+ * of explored nodes, or the records of a position file with their score. Records of interrupted searches have
+ * no score, their lines have the estimate of the search.
+ */
+template<class P>
+class ResultSink {
+public:
+    ResultSink(bool binary, BufferedWriter &output)
+            : output(output), records{binary ? new PositionRecordWriter<P>(output) : nullptr} {}
+
+    void write(const P &position, const char *moves, size_t length, int score, bool interrupted, unsigned long long nodeCount) {
+        if (records) {
+            records->write(PositionRecord<P>(position, interrupted ? PositionRecord<P>::NO_SCORE : score));
+        } else {
+            output.write(moves, length).write(' ').write(score).write(' ').write(nodeCount).write('\n');
+        }
     }
 
-    int columnOrder[Position::WIDTH] = {3, 2, 4, 1, 5, 0, 6};  // Static column order strategy (center columns first)
+private:
+    BufferedWriter &output;
+    std::unique_ptr<PositionRecordWriter<P>> records;  // Writer of records, or nullptr
+};
+
+/**
+ * A chunk of input positions solved together with BasicSolver::solveBatch().
+ * Batches are reused for the whole input, so that their buffers are only allocated by the first ones.
+ */
+template<class P>
+struct Batch {
+    std::string text;  // Move sequences of the batch, copied from the input since it may be overwritten by the next reads
+    std::vector<size_t> lineEnds;  // End of each move sequence in text
+    std::vector<P> positions;  // Positions of the batch, in input order
+    std::vector<int> scores;
+    std::vector<unsigned long long> nodeCounts;
+    std::vector<char> interruptions;  // Whether the search of each position was interrupted
+
+    size_t size() const {
+        return lineEnds.size();
+    }
 
-    for (int i = 0; i < Position::WIDTH; i++) {
-        int x = columnOrder[i];
-        if (currentPosition.canPlay(x) && !isLosingMove(currentPosition, x)) {
-            Position nextPosition(currentPosition);
-            nextPosition.play(x);
+    const char *line(size_t i) const {
+        return text.data() + (i ? lineEnds[i - 1] : 0);
+    }
 
-            // Use the TranspositionTable in the recursive calls
-            int score = -negamax(nextPosition, depth - 1, -beta, -alpha, startTime, transTable);
+    size_t lineLength(size_t i) const {
+        return lineEnds[i] - (i ? lineEnds[i - 1] : 0);
+    }
+};
+
+/**
+ * Reads up to size positions of the input into a batch.
+ */
+template<class P>
+static void readBatch(PositionSource<P> &input, size_t size, Batch<P> &batch) {
+    batch.text.clear();
+    batch.lineEnds.clear();
+    batch.positions.clear();
+    P position;
+    const char *moves;
+    size_t length;
+    while (batch.size() < size && input.next(position, moves, length)) {
+        batch.positions.push_back(position);
+        batch.text.append(moves, length);
+        batch.lineEnds.push_back(batch.text.size());
+    }
+}
 
-            if (score >= beta) {
-                return score; // Beta cutoff
-            }
+/**
+ * Writes the results of a solved batch, in input order.
+ */
+template<class P>
+static void writeBatch(const Batch<P> &batch, ResultSink<P> &output) {
+    for (size_t i = 0; i < batch.size(); i++) {
+        output.write(batch.positions[i], batch.line(i), batch.lineLength(i), batch.scores[i], batch.interruptions[i], batch.nodeCounts[i]);
+    }
+}
 
-            if (score > alpha) {
-                alpha = score; // Update alpha
-            }
+/**
+ * Solves the input in batches: while a batch is solved by the solver threads,
+ * the next one is parsed and the previous one is written.
+ */
+template<class P>
+static void runBatches(BasicSolver<P> &solver, PositionSource<P> &input, ResultSink<P> &output) {
+    const size_t BATCH_SIZE = 4096;
+    Batch<P> batches[2];  // The batch being solved and the batch being read then written
+    std::future<void> solving;  // Solves batches[current ^ 1] during each iteration
+
+    for (int current = 0;; current ^= 1) {
+        Batch<P> &batch = batches[current];
+        readBatch(input, BATCH_SIZE, batch);
+
+        bool hasSolved = solving.valid();
+        if (hasSolved) {
+            solving.get();
+        }
+        if (batch.size()) {
+            solving = std::async(std::launch::async, [&solver, &batch] {
+                batch.scores = solver.solveBatch(batch.positions, &batch.nodeCounts, &batch.interruptions);
+            });
+        }
+        if (hasSolved) {
+            writeBatch(batches[current ^ 1], output);
+        }
+        if (!solving.valid()) {
+            break;
         }
-
-        // Store the score in the TranspositionTable inside the loop
-        transTable.put(currentPosition.key(), static_cast<uint8_t>(alpha), false);
     }
-
-    return alpha;
 }
 
-int Connect4Solver::solve(const Position &initialPosition) {
-    exploredNodeCount = 0;
-    auto startTime = std::chrono::steady_clock::now();
-    TranspositionTable transTable;  // Create a TranspositionTable instance
-    transTable.reset();
+/**
+ * Writes the usage of the solver's TranspositionTable on the standard error.
+ */
+template<class P>
+static void writeCacheStats(const BasicSolver<P> &solver) {
+    typename BasicSolver<P>::CacheStats stats = solver.getCacheStats();
+    if (!BasicSolver<P>::CacheStats::COUNTED) {
+        std::cerr << "TranspositionTable stats are not counted by this build, see TRANSPOSITION_TABLE_STATS\n";
+        return;
+    }
+    std::cerr << "TranspositionTable: " << stats.size << " entries, occupancy " << stats.occupancy()
+              << ", hits " << stats.hits << ", misses " << stats.misses << ", hit rate " << stats.hitRate()
+              << ", stores " << stats.stores << ", replacements " << stats.replacements
+              << ", replacement rate " << stats.replacementRate() << ", mean probe length " << stats.meanProbeLength() << "\n";
+}
 
-    int bestScore = 0;  // Initialize with a neutral value
-    int depth;
+/**
+ * Writes the profile of the searches of the solve() calls on the standard error, see BasicSolver::SearchStats.
+ */
+template<class P>
+static void writeSearchStats(const typename BasicSolver<P>::SearchStats &stats) {
+    typedef typename BasicSolver<P>::SearchStats SearchStats;
+    if (!SearchStats::COUNTED) {
+        std::cerr << "Search stats are not counted by this build, see SEARCH_STATS\n";
+        return;
+    }
+    std::cerr << "Search: " << stats.nodeCount << " nodes, cutoffs " << stats.cutoffCount() << " by move index";
+    for (unsigned long long cutoffs : stats.cutoffs) {
+        std::cerr << " " << cutoffs;
+    }
+    std::cerr << ", first move cutoff rate " << stats.firstMoveCutoffRate() << ", TT probes " << stats.ttProbes
+              << ", hits " << stats.ttHits << ", hit rate " << stats.ttHitRate() << ", TT cutoffs " << stats.ttCutoffs;
+    if (SearchStats::TIMED) {
+        std::cerr << ", move ordering " << std::chrono::duration<double, std::milli>(stats.moveOrderingTime).count()
+                  << " ms, TT " << std::chrono::duration<double, std::milli>(stats.transTableTime).count()
+                  << " ms, evaluation " << std::chrono::duration<double, std::milli>(stats.evaluationTime).count() << " ms";
+    }
+    std::cerr << "\n";
+}
 
-    for (depth = 1; depth <= depthLimit; ++depth) {
-        int score = negamax(initialPosition, depth, std::numeric_limits<int>::min() + 1, std::numeric_limits<int>::max(), startTime, transTable);
-        auto endTime = std::chrono::steady_clock::now();
+/**
+ * Solves the standard input on a board geometry.
+ * The input is memory-mapped when it is a regular file and read by large blocks otherwise, and results are
+ * written by large blocks, flushed whenever the solver waits for more input so that interactive use still
+ * gets an answer for each line.
+ */
+template<class P>
+static int run(const Options &options) {
+    if ((options.binaryInput || options.binaryOutput) && !PositionRecord<P>::SUPPORTED) {
+        std::cerr << "Position files do not support the board\n";
+        return 1;
+    }
+    BasicSolver<P> solver(std::chrono::seconds(5), 10,
+                          options.nullWindow ? BasicSolver<P>::NULL_WINDOW : BasicSolver<P>::ITERATIVE_DEEPENING,
+                          options.memoryLimit);
+    solver.setOpeningBook(options.book);
+    solver.setEndgameTable(options.endgameTable);
+    solver.setThreadCount(options.threadCount);
+    solver.setVerbose(options.verbose);
+    if (options.cacheFile) {
+        solver.loadCache(options.cacheFile);  // A missing cache or the cache of another board starts empty
+    }
+    if (options.warmCacheFile && !solver.mapCache(options.warmCacheFile)) {
+        std::cerr << "Unable to map cache \"" << options.warmCacheFile << "\"\n";
+        return 1;
+    }
 
-        // Check if the time limit has been exceeded
-        if (endTime - startTime >= timeLimit) {
-            std::cout << "Time's up! ";
-            break;
+    BufferedWriter output(STDOUT_FILENO);
+    PositionSource<P> input(options.binaryInput, output);
+    if (!input.isValid()) {
+        std::cerr << "The input is not a position file of the board\n";
+        return 1;
+    }
+    ResultSink<P> results(options.binaryOutput, output);
+
+    typename BasicSolver<P>::SearchStats searchStats = typename BasicSolver<P>::SearchStats();  // Summed over the positions
+    if (options.batch) {
+        runBatches(solver, input, results);
+    } else {
+        P currentPosition;
+        const char *moves;
+        size_t length;
+        typename BasicSolver<P>::SearchStats positionStats;
+        while (input.next(currentPosition, moves, length)) {
+            int score = solver.solve(currentPosition, options.stats ? &positionStats : nullptr);
+            results.write(currentPosition, moves, length, score, solver.wasInterrupted(), solver.getExploredNodeCount());
+            if (options.stats) {
+                searchStats.add(positionStats);
+            }
+        }
+    }
+    output.flush();
+    if (options.stats) {
+        writeCacheStats(solver);
+        if (!options.batch) {
+            writeSearchStats<P>(searchStats);  // solveBatch() does not profile its searches
         }
-
-        // Update the best score
-        bestScore = score;
-        std::cout << "Depth " << depth << " completed. Nodes explored: " << exploredNodeCount << std::endl;
+    }
+    if (options.cacheFile && !solver.saveCache(options.cacheFile)) {
+        std::cerr << "Unable to save cache \"" << options.cacheFile << "\"\n";
+        return 1;
     }
 
-    std::cout << "Nodes explored: " << exploredNodeCount << std::endl;
-    std::cout << "Completed search up to depth " << (depth - 1) << ". ";
-    return bestScore;
+    return output.fail() ? 1 : 0;
 }
 
-int main() {
-    Connect4Solver solver(std::chrono::seconds(5), 10);
-    std::string line;
-
-    for (int lineNumber = 1; std::getline(std::cin, line); lineNumber++) {
-        Position currentPosition;
-        if (currentPosition.play(line) != line.size()) {  // Corrected method name
-            std::cerr << "Line " << lineNumber << ": Invalid move " << (currentPosition.nbMoves() + 1) << " \"" << line << "\"" << "\n";
-            continue;
+int main(int argc, char **argv) {
+    Options options;
+    std::string board = "7x6";
+    OpeningBook book;
+    EndgameTable endgameTable;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--null-window") {
+            options.nullWindow = true;
+        } else if (arg == "--batch") {
+            options.batch = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threadCount = std::stoi(argv[++i]);
+        } else if (arg == "--memory" && i + 1 < argc) {
+            options.memoryLimit = static_cast<size_t>(std::stoul(argv[++i])) << 20;  // In megabytes
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg == "--verbose") {
+            options.verbose = true;
+        } else if ((arg == "--input-format" || arg == "--output-format") && i + 1 < argc) {
+            std::string format = argv[++i];  // Lines of move sequences or position files, see PositionRecord
+            if (format != "text" && format != "binary") {
+                std::cerr << "Unsupported format \"" << format << "\"\n";
+                return 1;
+            }
+            (arg == "--input-format" ? options.binaryInput : options.binaryOutput) = format == "binary";
+        } else if (arg == "--cache" && i + 1 < argc) {
+            options.cacheFile = argv[++i];
+        } else if (arg == "--warm-cache" && i + 1 < argc) {
+            options.warmCacheFile = argv[++i];
+        } else if (arg == "--board" && i + 1 < argc) {
+            board = argv[++i];  // Geometry of the board, the research variants have no opening book
+        } else if (arg == "--book" && i + 1 < argc) {
+            if (!book.open(argv[++i])) {
+                std::cerr << "Unable to open book \"" << argv[i] << "\"\n";
+                return 1;
+            }
+            options.book = &book;
+        } else if (arg == "--endgame" && i + 1 < argc) {
+            if (!endgameTable.open(argv[++i])) {
+                std::cerr << "Unable to open endgame table \"" << argv[i] << "\"\n";
+                return 1;
+            }
+            options.endgameTable = &endgameTable;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--null-window] [--batch] [--threads <count>] [--memory <megabytes>] [--stats] [--verbose] [--input-format text|binary] [--output-format text|binary] [--board 7x6|6x5|8x7] [--book <file>] [--endgame <file>] [--cache <file>] [--warm-cache <file>]\n";
+            return 1;
         }
-        int score = solver.solve(currentPosition);
-        std::cout << line << " " << score << " " << solver.getExploredNodeCount() << "\n";
     }
 
-    return 0;
+    if (board == "7x6") {
+        return run<Position>(options);
+    } else if (board == "6x5") {
+        return run<BasicPosition<6, 5>>(options);
+    } else if (board == "8x7") {
+        return run<BasicPosition<8, 7>>(options);
+    }
+    std::cerr << "Unsupported board \"" << board << "\"\n";
+    return 1;
 }
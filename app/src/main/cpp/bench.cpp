@@ -0,0 +1,231 @@
+#include "solver.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace GameSolver::Connect4;
+
+/**
+ * Reference position sets of the benchmark, stored in CONNECT4_BENCH_DIR.
+ * Each line holds a move sequence and its exact score. Sets are named after the phase of the game
+ * and the number of nodes the NULL_WINDOW solver needed when they were generated:
+ * - end: more than 27 moves played, middle: 14 to 27 moves, begin: 7 to 13 moves
+ * - easy: less than 10^4 nodes, medium: 10^4 to 10^6 nodes, hard: more than 10^6 nodes
+ */
+static const char *const DEFAULT_SETS[] = {
+        "end_easy", "middle_easy", "middle_medium", "begin_easy", "begin_medium", "begin_hard"
+};
+
+/**
+ * Measures of the positions of a set.
+ */
+struct SetResult {
+    std::string name;
+    std::vector<double> times;  // Time per position, in microseconds
+    std::vector<double> nodes;  // Nodes explored per position
+    unsigned int errors = 0;  // Positions whose score differs from the reference score
+    Connect4Solver::CacheStats cacheStats;  // Usage of the TranspositionTable over the whole set
+};
+
+/**
+ * Summary of a measure over the positions of a set.
+ */
+struct Summary {
+    double mean, p50, p90, p99, max;
+};
+
+/**
+ * Computes the mean and nearest-rank percentiles of a measure.
+ */
+static Summary summarize(std::vector<double> values) {
+    Summary summary = {0, 0, 0, 0, 0};
+    if (values.empty()) {
+        return summary;
+    }
+    std::sort(values.begin(), values.end());
+    double sum = 0;
+    for (double value : values) {
+        sum += value;
+    }
+    auto percentile = [&values](unsigned int p) {
+        size_t rank = (values.size() * p + 99) / 100;  // 1-based rank of the percentile
+        return values[std::max<size_t>(rank, 1) - 1];
+    };
+    summary.mean = sum / values.size();
+    summary.p50 = percentile(50);
+    summary.p90 = percentile(90);
+    summary.p99 = percentile(99);
+    summary.max = values.back();
+    return summary;
+}
+
+static double total(const std::vector<double> &values) {
+    double sum = 0;
+    for (double value : values) {
+        sum += value;
+    }
+    return sum;
+}
+
+/**
+ * Solves every position of a set file with an empty cache, so that measures do not depend on the other positions.
+ * @return false if the file cannot be read or holds an invalid line.
+ */
+static bool runSet(Connect4Solver &solver, const std::string &path, SetResult &result) {
+    std::ifstream input(path);
+    if (!input) {
+        std::cerr << "Unable to open set \"" << path << "\"\n";
+        return false;
+    }
+    solver.resetCacheStats();
+    std::string line;
+    for (int lineNumber = 1; std::getline(input, line); lineNumber++) {
+        size_t separator = line.find(' ');
+        Position position;
+        if (separator == std::string::npos || position.play(line.data(), separator) != separator) {
+            std::cerr << path << ":" << lineNumber << ": Invalid position \"" << line << "\"\n";
+            return false;
+        }
+        int expected = std::stoi(line.substr(separator + 1));
+
+        solver.clearCache();
+        auto start = std::chrono::steady_clock::now();
+        int score = solver.solve(position);
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+        result.times.push_back(elapsed.count());
+        result.nodes.push_back(static_cast<double>(solver.getExploredNodeCount()));
+        if (score != expected) {
+            std::cerr << path << ":" << lineNumber << ": Score " << score << " instead of " << expected << "\n";
+            result.errors++;
+        }
+    }
+    result.cacheStats = solver.getCacheStats();
+    return true;
+}
+
+/**
+ * Writes a rate of the TranspositionTable, or nothing when the table does not count its stats.
+ */
+static void writeCacheRate(double rate, const char *missing) {
+    if (Connect4Solver::CacheStats::COUNTED) {
+        std::streamsize precision = std::cout.precision(4);
+        std::cout << rate;
+        std::cout.precision(precision);
+    } else {
+        std::cout << missing;
+    }
+}
+
+static void writeCsv(const std::vector<SetResult> &results) {
+    std::cout << "set,positions,errors,time_mean_us,time_p50_us,time_p90_us,time_p99_us,time_max_us,"
+                 "nodes_mean,nodes_p50,nodes_p90,nodes_p99,nodes_max,nodes_per_second,tt_hit_rate,tt_collision_rate\n";
+    for (const SetResult &result : results) {
+        Summary time = summarize(result.times);
+        Summary nodes = summarize(result.nodes);
+        double totalTime = total(result.times);
+        std::cout << result.name << "," << result.times.size() << "," << result.errors << ","
+                  << time.mean << "," << time.p50 << "," << time.p90 << "," << time.p99 << "," << time.max << ","
+                  << nodes.mean << "," << nodes.p50 << "," << nodes.p90 << "," << nodes.p99 << "," << nodes.max << ","
+                  << (totalTime > 0 ? total(result.nodes) / totalTime * 1e6 : 0) << ",";
+        writeCacheRate(result.cacheStats.hitRate(), "");
+        std::cout << ",";
+        writeCacheRate(result.cacheStats.replacementRate(), "");
+        std::cout << "\n";
+    }
+}
+
+static void writeSummary(const char *name, const Summary &summary) {
+    std::cout << "\"" << name << "\": {\"mean\": " << summary.mean << ", \"p50\": " << summary.p50 << ", \"p90\": "
+              << summary.p90 << ", \"p99\": " << summary.p99 << ", \"max\": " << summary.max << "}";
+}
+
+static void writeJson(const std::vector<SetResult> &results) {
+    std::cout << "{\"sets\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const SetResult &result = results[i];
+        double totalTime = total(result.times);
+        std::cout << (i ? ",\n  " : "\n  ") << "{\"set\": \"" << result.name << "\", \"positions\": " << result.times.size()
+                  << ", \"errors\": " << result.errors << ", ";
+        writeSummary("time_us", summarize(result.times));
+        std::cout << ", ";
+        writeSummary("nodes", summarize(result.nodes));
+        std::cout << ", \"nodes_per_second\": " << (totalTime > 0 ? total(result.nodes) / totalTime * 1e6 : 0)
+                  << ", \"tt_hit_rate\": ";
+        writeCacheRate(result.cacheStats.hitRate(), "null");
+        std::cout << ", \"tt_collision_rate\": ";
+        writeCacheRate(result.cacheStats.replacementRate(), "null");
+        std::cout << "}";
+    }
+    std::cout << "\n]}\n";
+}
+
+/**
+ * Solves reference position sets and reports time and nodes per position, to compare builds.
+ * TranspositionTable rates are reported by builds counting its stats, see TRANSPOSITION_TABLE_STATS.
+ * Exits with status 1 if a score is wrong, so that the benchmark can run in continuous integration.
+ */
+int main(int argc, char **argv) {
+    bool csv = false;
+    bool iterativeDeepening = false;
+    unsigned int threadCount = 1;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format != "json" && format != "csv") {
+                std::cerr << "Unsupported format \"" << format << "\"\n";
+                return 1;
+            }
+            csv = format == "csv";
+        } else if (arg == "--iterative-deepening") {
+            iterativeDeepening = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threadCount = std::stoi(argv[++i]);
+        } else if (!arg.empty() && arg[0] != '-') {
+            paths.push_back(arg);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--format json|csv] [--iterative-deepening] [--threads <count>] [<set file>...]\n";
+            return 1;
+        }
+    }
+    if (paths.empty()) {
+        for (const char *set : DEFAULT_SETS) {
+            paths.push_back(std::string(CONNECT4_BENCH_DIR) + "/" + set + ".txt");
+        }
+    }
+
+    Connect4Solver solver(std::chrono::steady_clock::duration::max(), std::numeric_limits<int>::max(),
+                          iterativeDeepening ? Connect4Solver::ITERATIVE_DEEPENING : Connect4Solver::NULL_WINDOW);
+    solver.setThreadCount(threadCount);
+
+    std::vector<SetResult> results;
+    bool failed = false;
+    for (const std::string &path : paths) {
+        SetResult result;
+        result.name = path.substr(path.find_last_of('/') + 1);
+        if (result.name.size() > 4 && result.name.compare(result.name.size() - 4, 4, ".txt") == 0) {
+            result.name.resize(result.name.size() - 4);
+        }
+        if (!runSet(solver, path, result)) {
+            failed = true;
+            continue;
+        }
+        failed |= result.errors > 0;
+        results.push_back(result);
+    }
+    std::cout << std::fixed << std::setprecision(1);
+
+    if (csv) {
+        writeCsv(results);
+    } else {
+        writeJson(results);
+    }
+    return failed ? 1 : 0;
+}
@@ -1,8 +1,11 @@
 #ifndef BOARD_HPP
 #define BOARD_HPP
 
+#include "threat_kernel.hpp"
 #include <string>
 #include <cstdint>
+#include <type_traits>
+#include <vector>
 
 namespace GameSolver { namespace Connect4 {
 
@@ -11,9 +14,67 @@ namespace GameSolver { namespace Connect4 {
             PLAYER_O = 0
         };
 
+        // return a bitmask containing a single 1 on the bottom cell of each of the first width columns
+        template<class Bitboard>
+        constexpr Bitboard bottom(int width, int height) {
+            return width == 0 ? 0 : bottom<Bitboard>(width - 1, height) | Bitboard(1) << (width - 1) * (height + 1);
+        }
+
+        /**
+         * Selects the unsigned integer type of the bitboards of a given number of bits.
+         * Bitboards of more than 64 bits use the 128 bits integers of GCC and Clang, only
+         * available on 64 bits targets.
+         */
+        template<int Bits, bool Small = (Bits <= 64)>
+        struct bitboard {
+            typedef uint64_t type;
+        };
+#ifdef __SIZEOF_INT128__
+        template<int Bits>
+        struct bitboard<Bits, false> {
+            typedef __uint128_t type;
+        };
+#endif
+
+        // return a bitmask containing a 1 on every other cell of a column of a given height, starting with the bottom one
+        template<class Bitboard>
+        constexpr Bitboard alternateCells(int height) {
+            return height <= 0 ? 0 : alternateCells<Bitboard>(height - 2) | Bitboard(1) << (height - 1 - (height - 1) % 2);
+        }
+
+        template<int... I> struct indices {};
+        template<int N, int... I> struct makeIndices : makeIndices<N - 1, N - 1, I...> {};
+        template<int... I> struct makeIndices<0, I...> { typedef indices<I...> type; };
+
+        /**
+         * Masks of the cells of each column of a board, built at compile time.
+         * @tparam Columns indices<0, ..., WIDTH - 1>
+         */
+        template<class Bitboard, int Height, class Columns> struct ColumnMasks;
+
+        template<class Bitboard, int Height, int... Col>
+        struct ColumnMasks<Bitboard, Height, indices<Col...>> {
+            static constexpr Bitboard BOTTOM[sizeof...(Col)] = {Bitboard(1) << Col * (Height + 1)...};  // bottom cell
+            static constexpr Bitboard TOP[sizeof...(Col)] = {Bitboard(1) << (Height - 1 + Col * (Height + 1))...};  // top cell
+            static constexpr Bitboard COLUMN[sizeof...(Col)] = {((Bitboard(1) << Height) - 1) << Col * (Height + 1)...};  // all cells
+            static constexpr int ORDER[sizeof...(Col)] = {int(sizeof...(Col)) / 2 + (Col % 2 ? -((Col + 1) / 2) : Col / 2)...};  // center first
+        };
+
+        template<class Bitboard, int Height, int... Col>
+        constexpr Bitboard ColumnMasks<Bitboard, Height, indices<Col...>>::BOTTOM[sizeof...(Col)];
+        template<class Bitboard, int Height, int... Col>
+        constexpr Bitboard ColumnMasks<Bitboard, Height, indices<Col...>>::TOP[sizeof...(Col)];
+        template<class Bitboard, int Height, int... Col>
+        constexpr Bitboard ColumnMasks<Bitboard, Height, indices<Col...>>::COLUMN[sizeof...(Col)];
+        template<class Bitboard, int Height, int... Col>
+        constexpr int ColumnMasks<Bitboard, Height, indices<Col...>>::ORDER[sizeof...(Col)];
+
         /**
          * A class storing a Connect 4 position.
          * Functions are relative to the current player to play.
+         *
+         * The board geometry is a template parameter so that every variant gets its own code, with
+         * its masks as compile-time constants; Position is the standard 7x6 board.
          * Positions containing alignments are not supported by this class.
          *
          * A binary bitboard representation is used.
@@ -59,16 +120,39 @@ namespace GameSolver { namespace Connect4 {
          * key is a unique representation of a board key = position + mask + bottom
          * in practice, as the bottom is constant, key = position + mask is also a
          * non-ambiguous representation of the position.
+         *
+         * Mirrored copies of both bitboards are maintained by play() so that the key of
+         * the left-right mirror of the position, and the canonical key shared by a position
+         * and its mirror, cost a single addition.
+         *
+         * The cells completing an alignment for each player are maintained as well. A move only
+         * changes the alignments of the player making it, so play() and undo() recompute a single
+         * player's cells and the threat queries of the search are a few bitwise operations.
+         * The search plays and undoes moves in place on a single position.
+         *
+         * @tparam Width number of columns of the board.
+         * @tparam Height number of rows of the board.
          */
-        class Position {
+        template<int Width, int Height>
+        class BasicPosition {
         public:
-            static const int WIDTH = 7;  // width of the board
-            static const int HEIGHT = 6; // height of the board
+            static const int WIDTH = Width;  // width of the board
+            static const int HEIGHT = Height; // height of the board
             static const int MIN_SCORE = -(WIDTH*HEIGHT)/2 + 3;  // Minimum possible score
             static const int MAX_SCORE = (WIDTH*HEIGHT+1)/2 - 3;  // Maximum possible score
+            static const int KEY_BITS = WIDTH * (HEIGHT + 1);  // Number of significant bits of the keys
 
             static_assert(WIDTH < 10, "Board's width must be less than 10");
-            static_assert(WIDTH * (HEIGHT + 1) <= 64, "Board does not fit in 64bits bitboard");
+#ifdef __SIZEOF_INT128__
+            static_assert(KEY_BITS <= 128, "Board does not fit in 128bits bitboard");
+#else
+            static_assert(KEY_BITS <= 64, "Board does not fit in 64bits bitboard");
+#endif
+
+            typedef typename bitboard<KEY_BITS>::type bitboard_t;  // Type of the bitboards and keys
+
+            static constexpr bitboard_t BOTTOM_MASK = bottom<bitboard_t>(WIDTH, HEIGHT);  // 1 on the bottom cell of each column
+            static constexpr bitboard_t BOARD_MASK = BOTTOM_MASK * ((bitboard_t(1) << HEIGHT) - 1);  // 1 on every cell of the board
 
             /**
              * Indicates whether a column is playable.
@@ -88,14 +172,39 @@ namespace GameSolver { namespace Connect4 {
              */
             void play(int col)
             {
+                bitboard_t move = (mask + bottomMask(col)) & columnMask(col);
+                bitboard_t threats = computeThreats(currentPosition | move);
+                currentThreats = opponentThreats;  // the opponent's stones do not change
+                opponentThreats = threats;
                 currentPosition ^= mask;
-                mask |= mask + bottomMask(col);
+                mask |= move;
+                mirrorPosition ^= mirrorMask;
+                mirrorMask |= mirrorMask + bottomMask(WIDTH - 1 - col);
                 moves++;
             }
 
+            /**
+             * Takes back the last move played in a column, restoring the position before play(col).
+             * This function should only be called on a column whose top stone is the last move played.
+             *
+             * @param col: 0-based index of the column of the last move.
+             */
+            void undo(int col)
+            {
+                mask ^= ((mask & columnMask(col)) + bottomMask(col)) >> 1;  // remove the top stone of the column
+                currentPosition ^= mask;
+                int mirrorCol = WIDTH - 1 - col;
+                mirrorMask ^= ((mirrorMask & columnMask(mirrorCol)) + bottomMask(mirrorCol)) >> 1;
+                mirrorPosition ^= mirrorMask;
+                opponentThreats = currentThreats;
+                currentThreats = computeThreats(currentPosition);
+                moves--;
+            }
+
             /**
              * Plays a sequence of successive played columns, mainly used to initialize a board.
              * @param seq: a sequence of digits corresponding to the 1-based index of the column played.
+             * @param length: number of characters of the sequence, which does not need to be null-terminated.
              *
              * @return number of played moves. Processing will stop at the first invalid move that can be:
              *           - invalid character (non-digit, or digit >= WIDTH)
@@ -104,14 +213,19 @@ namespace GameSolver { namespace Connect4 {
              *         The caller can check if the move sequence was valid by comparing the number of
              *         processed moves to the length of the sequence.
              */
-            unsigned int play(std::string seq)
+            unsigned int play(const char *seq, size_t length)
             {
-                for(unsigned int i = 0; i < seq.size(); i++) {
+                for(unsigned int i = 0; i < length; i++) {
                     int col = seq[i] - '1';
-                    if(col < 0 || col >= Position::WIDTH || !canPlay(col) || isWinningMove(col)) return i; // invalid move
+                    if(col < 0 || col >= WIDTH || !canPlay(col) || isWinningMove(col)) return i; // invalid move
                     play(col);
                 }
-                return seq.size();
+                return length;
+            }
+
+            unsigned int play(const std::string &seq)
+            {
+                return play(seq.data(), seq.size());
             }
 
             /**
@@ -122,9 +236,108 @@ namespace GameSolver { namespace Connect4 {
              */
             bool isWinningMove(int col) const
             {
-                uint64_t pos = currentPosition;
-                pos |= (mask + bottomMask(col)) & columnMask(col);
-                return alignment(pos);
+                return winningPosition() & possible() & columnMask(col);
+            }
+
+            /**
+             * @return a bitmap of the cells that can be played next, one per non-full column.
+             */
+            bitboard_t possible() const
+            {
+                return (mask + BOTTOM_MASK) & BOARD_MASK;
+            }
+
+            /**
+             * @return a bitmap of the empty cells completing an alignment for the current player.
+             */
+            bitboard_t winningPosition() const
+            {
+                return currentThreats & ~mask;
+            }
+
+            /**
+             * @return a bitmap of the empty cells completing an alignment for the opponent.
+             */
+            bitboard_t opponentWinningPosition() const
+            {
+                return opponentThreats & ~mask;
+            }
+
+            /**
+             * Indicates whether the current player can win with their next move.
+             */
+            bool canWinNext() const
+            {
+                return winningPosition() & possible();
+            }
+
+            /**
+             * Computes the moves that do not let the opponent win with their next move.
+             * This function should only be called when the current player cannot win with their next move.
+             * @return a bitmap of the playable cells that do not make the current player lose on the
+             *         following move, 0 if every move loses.
+             */
+            bitboard_t possibleNonLosingMoves() const
+            {
+                bitboard_t possibleMask = possible();
+                bitboard_t opponentWin = opponentWinningPosition();
+                bitboard_t forcedMoves = possibleMask & opponentWin;
+                if(forcedMoves) {
+                    if(forcedMoves & (forcedMoves - 1)) return 0; // the opponent has two winning moves, we cannot stop both
+                    possibleMask = forcedMoves; // we have to block the opponent's winning move
+                }
+                return possibleMask & ~(opponentWin >> 1); // never play just below an opponent's winning cell
+            }
+
+            /**
+             * Scores a possible move by the number of winning cells the current player has after playing it.
+             * @param move: a bitmap with a single 1 on the cell to play, taken from possible().
+             * @return the number of empty cells completing an alignment after the move.
+             */
+            int moveScore(bitboard_t move) const
+            {
+                return popcount(computeWinningPosition(currentPosition | move, mask));
+            }
+
+            /**
+             * Scores several possible moves at once, as moveScore() does for each of them.
+             * @param moves: a bitmap with at most one cell per column, taken from possible().
+             * @param scores: WIDTH scores, set for the columns of the moves and meaningless for the others.
+             */
+            void moveScores(bitboard_t moves, int *scores) const
+            {
+                scoreMoves(moves, scores, std::integral_constant<bool, KEY_BITS <= 64>());
+            }
+
+            /**
+             * Estimates the score of the position without searching, for the leaves of depth-limited searches.
+             * The estimate only uses popcounts over the threat bitboards and constant masks:
+             * - empty cells completing an alignment, worth more on the rows where the player's threats
+             *   decide the end of the game: odd rows (1st, 3rd...) for the first player, even rows for the second
+             * - stones in the center columns, part of the most alignments
+             * This function should only be called when the current player cannot win with their next move
+             * and has a non-losing move.
+             * @return an estimated score, within the range of the scores of such positions and [MIN_SCORE, MAX_SCORE].
+             */
+            int evaluate() const
+            {
+                // the first player moves on even move counts, zugzwang gives them the odd rows at the end of the game
+                bool first = moves % 2 == 0;
+                bitboard_t ownRows = first ? ODD_ROWS_MASK : BOARD_MASK ^ ODD_ROWS_MASK;
+                bitboard_t own = winningPosition();
+                bitboard_t opponent = opponentWinningPosition();
+                int points = THREAT_WEIGHT * (popcount(own) - popcount(opponent)) +
+                             PARITY_WEIGHT * (popcount(own & ownRows) - popcount(opponent & ~ownRows)) +
+                             CENTER_WEIGHT * (popcount(currentPosition & CENTER_MASK) - popcount((currentPosition ^ mask) & CENTER_MASK));
+
+                // a win with the next move and a loss with the opponent's next move are excluded, and no player
+                // wins before their 4th stone
+                int max = (WIDTH * HEIGHT - 1 - static_cast<int>(moves)) / 2;
+                int min = -(WIDTH * HEIGHT - 2 - static_cast<int>(moves)) / 2;
+                if(max > MAX_SCORE) max = MAX_SCORE;
+                if(min < MIN_SCORE) min = MIN_SCORE;
+                int score = points / POINTS_PER_SCORE;
+                return score > max ? max : score < min ? min : score;
             }
 
             /**
@@ -138,62 +351,240 @@ namespace GameSolver { namespace Connect4 {
             /**
              * @return a compact representation of a position on WIDTH * (HEIGHT+1) bits.
              */
-            uint64_t key() const
+            bitboard_t key() const
             {
                 return currentPosition + mask;
             }
 
+            /**
+             * @return the key of the left-right mirror of the position.
+             */
+            bitboard_t mirrorKey() const
+            {
+                return mirrorPosition + mirrorMask;
+            }
+
+            /**
+             * @return a key shared by a position and its left-right mirror, the smallest of both keys.
+             */
+            bitboard_t canonicalKey() const
+            {
+                bitboard_t k = key();
+                bitboard_t m = mirrorKey();
+                return k < m ? k : m;
+            }
+
+            /**
+             * Computes the canonicalKey() of the position after a move, without playing it.
+             * @param col: 0-based index of a playable column.
+             */
+            bitboard_t canonicalKeyAfter(int col) const
+            {
+                bitboard_t k = (currentPosition ^ mask) + (mask | (mask + bottomMask(col)));
+                bitboard_t m = (mirrorPosition ^ mirrorMask) + (mirrorMask | (mirrorMask + bottomMask(WIDTH - 1 - col)));
+                return k < m ? k : m;
+            }
+
+            /**
+             * Sets the position of a key returned by key(), without replaying its moves.
+             * In each column, the key holds the current player's stones plus a 1 on every stone, so the
+             * column's field is at least 2^h - 1 and less than 2^(h+1) - 1 for a column of height h.
+             * @param k: a key of a position of the board.
+             * @return true if the key is a position of a game without alignment, the position is unchanged otherwise.
+             */
+            bool setKey(bitboard_t k)
+            {
+                bitboard_t m = 0;
+                unsigned int count = 0;
+                for(int col = 0; col < WIDTH; col++) {
+                    bitboard_t field = (k & (columnMask(col) | topMask(col) << 1)) >> col * (HEIGHT + 1);
+                    int height = 0;
+                    while(height < HEIGHT && field + 1 >= bitboard_t(2) << height) height++;
+                    if(field + 1 >= bitboard_t(2) << height) return false;  // the column holds more than HEIGHT stones
+                    m |= ((bitboard_t(1) << height) - 1) << col * (HEIGHT + 1);
+                    count += height;
+                }
+                bitboard_t p = k - m;
+                if((k & ~(BOARD_MASK | BOARD_MASK << 1)) != 0 || popcount(p) != static_cast<int>(count / 2) ||
+                   (computeThreats(p) & p) || (computeThreats(p ^ m) & (p ^ m))) {
+                    return false;  // bits outside of the columns, a wrong number of stones or an alignment
+                }
+
+                currentPosition = p;
+                mask = m;
+                mirrorPosition = 0;
+                mirrorMask = 0;
+                for(int col = 0; col < WIDTH; col++) {
+                    int shift = (WIDTH - 1 - 2 * col) * (HEIGHT + 1);
+                    mirrorPosition |= shift >= 0 ? (p & columnMask(col)) << shift : (p & columnMask(col)) >> -shift;
+                    mirrorMask |= shift >= 0 ? (m & columnMask(col)) << shift : (m & columnMask(col)) >> -shift;
+                }
+                currentThreats = computeThreats(p);
+                opponentThreats = computeThreats(p ^ m);
+                moves = count;
+                return true;
+            }
+
+            /**
+             * Finds an order of the moves of the position, such as the order of a game reaching it.
+             * Stones are taken back depth first from the top of the columns, the last player's in turn.
+             * Positions without alignment never had one, so any such order replays through play().
+             * Keys of unreachable positions fail in polynomial time: the heights of the columns are searched
+             * at most once each.
+             * @param seq: set to the 1-based indexes of the columns played, as read by play(), if an order exists.
+             * @return true if an order was found, false if the stones of the players cannot alternate.
+             */
+            bool moveSequence(std::string &seq) const
+            {
+                BasicPosition position(*this);
+                seq.resize(moves);
+                std::vector<bool> failed;  // Column heights from which no order exists, allocated once a few are found
+                unsigned int failures = 0;
+                size_t weights[WIDTH];  // Weight of each column in the heights, in base HEIGHT + 1
+                size_t heights = 0;
+                for(int col = 0; col < WIDTH; col++) {
+                    weights[col] = col ? weights[col - 1] * (HEIGHT + 1) : 1;
+                    heights += popcount(mask & columnMask(col)) * weights[col];
+                }
+                return position.takeBack(seq, failed, failures, heights, weights);
+            }
+
             /**
              * Default constructor, build an empty position.
              */
-            Position() : currentPosition{0}, mask{0}, moves{0} {}
+            BasicPosition() : currentPosition{0}, mask{0}, mirrorPosition{0}, mirrorMask{0}, currentThreats{0}, opponentThreats{0}, moves{0} {}
 
         private:
-            uint64_t currentPosition;  // Bitboard for the current player's stones
-            uint64_t mask;  // Bitboard for all stones (both players)
+            bitboard_t currentPosition;  // Bitboard for the current player's stones
+            bitboard_t mask;  // Bitboard for all stones (both players)
+            bitboard_t mirrorPosition;  // currentPosition with its columns in reverse order, updated by play()
+            bitboard_t mirrorMask;  // mask with its columns in reverse order, updated by play()
+            bitboard_t currentThreats;  // cells of the board completing an alignment for the current player, empty or not
+            bitboard_t opponentThreats;  // cells of the board completing an alignment for the opponent, empty or not
             unsigned int moves; // number of moves played since the beginning of the game.
 
+            // return the number of bits set to 1 in a bitmap
+            static int popcount(uint64_t m) {
+#if defined(__GNUC__)
+                return __builtin_popcountll(m);
+#else
+                int c = 0;
+                for(; m; c++) m &= m - 1;
+                return c;
+#endif
+            }
+
+#ifdef __SIZEOF_INT128__
+            static int popcount(__uint128_t m) {
+                return popcount(static_cast<uint64_t>(m)) + popcount(static_cast<uint64_t>(m >> 64));
+            }
+#endif
+
+            typedef ColumnMasks<bitboard_t, HEIGHT, typename makeIndices<WIDTH>::type> Columns;
+
+            static constexpr bitboard_t ODD_ROWS_MASK = BOTTOM_MASK * alternateCells<bitboard_t>(HEIGHT);  // 1st, 3rd... rows from the bottom
+            static constexpr bitboard_t CENTER_MASK = Columns::COLUMN[WIDTH / 2] | Columns::COLUMN[(WIDTH - 1) / 2];  // one or two center columns
+
+            // weights of evaluate(), in points
+            static const int THREAT_WEIGHT = 2;  // empty cell completing an alignment
+            static const int PARITY_WEIGHT = 3;  // additional weight of a threat on the player's rows
+            static const int CENTER_WEIGHT = 1;  // stone in the center columns
+            static const int POINTS_PER_SCORE = 2;
+
+            /**
+             * Computes the empty cells completing an alignment for a player.
+             * @param position bitboard of the player's stones.
+             * @param mask bitboard of all stones.
+             * @return a bitmap of the empty cells where the player would make an alignment.
+             */
+            static bitboard_t computeWinningPosition(bitboard_t position, bitboard_t mask) {
+                return computeThreats(position) & ~mask;
+            }
+
             /**
-             * Test an alignment for the current player (identified by one in the bitboard pos).
-             * @param a bitboard position of a player's cells.
-             * @return true if the player has a 4-alignment.
+             * Computes the cells completing an alignment for a player, empty or not.
+             * @param position bitboard of the player's stones.
+             * @return a bitmap of the cells where the player would make an alignment.
              */
-            static bool alignment(uint64_t pos) {
-                // horizontal
-                uint64_t m = pos & (pos >> (HEIGHT + 1));
-                if(m & (m >> (2 * (HEIGHT + 1)))) return true;
+            static bitboard_t computeThreats(bitboard_t position) {
+                return ThreatKernel<WIDTH, HEIGHT>::threats(position) & BOARD_MASK;
+            }
 
-                // diagonal 1
-                m = pos & (pos >> HEIGHT);
-                if(m & (m >> (2 * HEIGHT))) return true;
+            // score moves with the vectorized ThreatKernel, for bitboards of 64 bits
+            void scoreMoves(bitboard_t moves, int *scores, std::true_type) const {
+                ThreatKernel<WIDTH, HEIGHT>::get()(currentPosition, moves, BOARD_MASK & ~mask, scores);
+            }
+
+            // score moves one at a time, for wider bitboards
+            void scoreMoves(bitboard_t moves, int *scores, std::false_type) const {
+                for(int col = 0; col < WIDTH; col++) {
+                    bitboard_t move = moves & columnMask(col);
+                    if(move) scores[col] = moveScore(move);
+                }
+            }
 
-                // diagonal 2
-                m = pos & (pos >> (HEIGHT + 2));
-                if(m & (m >> (2 * (HEIGHT + 2)))) return true;
+            static const unsigned int TAKE_BACK_FAILURES = 1024;  // failed column heights before takeBack() remembers them
 
-                // vertical;
-                m = pos & (pos >> 1);
-                if(m & (m >> 2)) return true;
+            // take back every move, filling their columns in seq, see moveSequence()
+            // The stones left only depend on the heights of the columns, so heights that failed once are not searched again,
+            // once enough of them failed to be worth the memory: most positions only take back a few wrong stones
+            bool takeBack(std::string &seq, std::vector<bool> &failed, unsigned int &failures, size_t heights, const size_t *weights)
+            {
+                if(moves == 0) return true;
+                if(!failed.empty() && failed[heights]) return false;
 
+                bitboard_t lastPlayer = currentPosition ^ mask;
+                for(int col = 0; col < WIDTH; col++) {
+                    bitboard_t top = (((mask & columnMask(col)) + bottomMask(col)) >> 1) & columnMask(col);
+                    if(!(top & lastPlayer)) continue;
+                    undo(col);
+                    seq[moves] = static_cast<char>('1' + col);
+                    if(takeBack(seq, failed, failures, heights - weights[col], weights)) return true;
+                    play(col);
+                }
+                if(failed.empty() && ++failures >= TAKE_BACK_FAILURES) failed.resize(weights[WIDTH - 1] * (HEIGHT + 1));
+                if(!failed.empty()) failed[heights] = true;
                 return false;
             }
 
             // return a bitmask containing a single 1 corresponding to the top cell of a given column
-            static uint64_t topMask(int col) {
-                return (UINT64_C(1) << (HEIGHT - 1)) << col * (HEIGHT + 1);
+            static bitboard_t topMask(int col) {
+                return Columns::TOP[col];
             }
 
             // return a bitmask containing a single 1 corresponding to the bottom cell of a given column
-            static uint64_t bottomMask(int col) {
-                return UINT64_C(1) << col * (HEIGHT + 1);
+            static bitboard_t bottomMask(int col) {
+                return Columns::BOTTOM[col];
             }
 
+        public:
             // return a bitmask 1 on all the cells of a given column
-            static uint64_t columnMask(int col) {
-                return ((UINT64_C(1) << HEIGHT) - 1) << col * (HEIGHT + 1);
+            static bitboard_t columnMask(int col) {
+                return Columns::COLUMN[col];
+            }
+
+            // return the columns ordered from the center to the edges, left first: 3, 2, 4, 1, 5, 0, 6 on 7 columns
+            static int orderedColumn(int i) {
+                return Columns::ORDER[i];
             }
         };
 
+        template<int Width, int Height> const int BasicPosition<Width, Height>::WIDTH;
+        template<int Width, int Height> const int BasicPosition<Width, Height>::HEIGHT;
+        template<int Width, int Height> const int BasicPosition<Width, Height>::MIN_SCORE;
+        template<int Width, int Height> const int BasicPosition<Width, Height>::MAX_SCORE;
+        template<int Width, int Height> const int BasicPosition<Width, Height>::KEY_BITS;
+        template<int Width, int Height>
+        constexpr typename BasicPosition<Width, Height>::bitboard_t BasicPosition<Width, Height>::BOTTOM_MASK;
+        template<int Width, int Height>
+        constexpr typename BasicPosition<Width, Height>::bitboard_t BasicPosition<Width, Height>::BOARD_MASK;
+        template<int Width, int Height>
+        constexpr typename BasicPosition<Width, Height>::bitboard_t BasicPosition<Width, Height>::ODD_ROWS_MASK;
+        template<int Width, int Height>
+        constexpr typename BasicPosition<Width, Height>::bitboard_t BasicPosition<Width, Height>::CENTER_MASK;
+
+        typedef BasicPosition<7, 6> Position;  // The standard board
+
     }} // end namespaces
 
 #endif
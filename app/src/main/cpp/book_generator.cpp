@@ -0,0 +1,69 @@
+#include "solver.hpp"
+#include "opening_book.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+using namespace GameSolver::Connect4;
+
+/**
+ * Collects every position reachable with at most maxPlies moves, a single one per mirror pair.
+ */
+static void explore(const Position &position, unsigned int maxPlies, std::unordered_set<uint64_t> &visited,
+                    std::vector<Position> &positions) {
+    if (!visited.insert(position.canonicalKey()).second) {
+        return;  // Already reached through another move order, or as a mirror
+    }
+    positions.push_back(position);
+    if (position.nbMoves() >= maxPlies) {
+        return;
+    }
+
+    for (int col = 0; col < Position::WIDTH; col++) {
+        // Games stop at the first alignment, so winning moves do not lead to book positions
+        if (position.canPlay(col) && !position.isWinningMove(col)) {
+            Position next(position);
+            next.play(col);
+            explore(next, maxPlies, visited, positions);
+        }
+    }
+}
+
+/**
+ * Generates an opening book with the exact score of every position up to a number of plies.
+ */
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <plies> <output book file>\n";
+        return 1;
+    }
+    char *parsed;
+    unsigned long plies = std::strtoul(argv[1], &parsed, 10);  // Negative numbers wrap beyond the board
+    if (!*argv[1] || *parsed || plies > Position::WIDTH * Position::HEIGHT) {
+        std::cerr << "Invalid number of plies \"" << argv[1] << "\"\n";
+        return 1;
+    }
+    unsigned int maxPlies = static_cast<unsigned int>(plies);
+
+    std::unordered_set<uint64_t> visited;
+    std::vector<Position> positions;
+    explore(Position(), maxPlies, visited, positions);
+    std::cerr << positions.size() << " positions up to " << maxPlies << " plies\n";
+
+    Connect4Solver solver(std::chrono::steady_clock::duration::max(), std::numeric_limits<int>::max(), Connect4Solver::NULL_WINDOW);
+    std::vector<uint64_t> entries;
+    entries.reserve(positions.size());
+    for (const Position &position : positions) {
+        entries.push_back(OpeningBook::packEntry(position.canonicalKey(), solver.solve(position)));
+        if (entries.size() % 1000 == 0) {
+            std::cerr << entries.size() << " / " << positions.size() << " positions solved\n";
+        }
+    }
+
+    if (!OpeningBook::write(argv[2], entries, maxPlies)) {
+        std::cerr << "Unable to write book \"" << argv[2] << "\"\n";
+        return 1;
+    }
+    return 0;
+}
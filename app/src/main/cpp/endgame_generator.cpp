@@ -0,0 +1,92 @@
+#include "solver.hpp"
+#include "endgame_table.hpp"
+#include "opening_book.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace GameSolver::Connect4;
+
+/**
+ * Collects every position with at least minMoves moves that a search from a position can reach, a single one
+ * per mirror pair. The search scores positions where the player to move can win or cannot avoid losing without
+ * searching, so they are neither collected nor explored, and it only plays moves that do not lose at once.
+ */
+static void explore(const Position &position, unsigned int minMoves, std::unordered_set<uint64_t> &visited,
+                    std::vector<Position> &positions) {
+    if (!visited.insert(position.canonicalKey()).second || position.canWinNext()) {
+        return;  // Already reached through another move order or as a mirror, or scored without searching
+    }
+    Position::bitboard_t moves = position.possibleNonLosingMoves();
+    if (moves == 0) {
+        return;
+    }
+    if (position.nbMoves() >= minMoves) {
+        positions.push_back(position);
+    }
+
+    for (int col = 0; col < Position::WIDTH; col++) {
+        if (moves & Position::columnMask(col)) {
+            Position next(position);
+            next.play(col);
+            explore(next, minMoves, visited, positions);
+        }
+    }
+}
+
+/**
+ * Generates an endgame table with the exact scores of the positions with at most a number of empty cells
+ * that searches from seed positions reach, the seeds being the move sequences read on the standard input,
+ * one per line. The table does not cover the other positions with as many empty cells, whose lookups miss
+ * and which the solver keeps searching.
+ *
+ * The number of positions grows exponentially with the number of moves between the seeds and the table,
+ * seeds are expected to be a few moves away from the table, e.g. positions of a game corpus at their last
+ * moves before the table.
+ */
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <empty cells> <output table file> < <seed move sequences>\n"
+                  << "The table holds the positions with at most <empty cells> empty cells reachable from the seeds.\n";
+        return 1;
+    }
+    char *parsed;
+    unsigned long emptyCells = std::strtoul(argv[1], &parsed, 10);  // Negative numbers wrap beyond the board
+    if (!*argv[1] || *parsed || emptyCells > Position::WIDTH * Position::HEIGHT) {
+        std::cerr << "Invalid number of empty cells \"" << argv[1] << "\"\n";
+        return 1;
+    }
+    unsigned int minMoves = Position::WIDTH * Position::HEIGHT - static_cast<unsigned int>(emptyCells);
+
+    std::unordered_set<uint64_t> visited;
+    std::vector<Position> positions;
+    std::string line;
+    for (int lineNumber = 1; std::getline(std::cin, line); lineNumber++) {
+        std::string moves = line.substr(0, line.find(' '));  // Lines of position sets also hold a score
+        Position position;
+        if (position.play(moves) != moves.size()) {
+            std::cerr << "Line " << lineNumber << ": Invalid move " << (position.nbMoves() + 1) << " \"" << line << "\"\n";
+            continue;
+        }
+        explore(position, minMoves, visited, positions);
+    }
+    std::cerr << positions.size() << " positions with at most " << emptyCells << " empty cells reachable from the seeds\n";
+
+    Connect4Solver solver(std::chrono::steady_clock::duration::max(), std::numeric_limits<int>::max(), Connect4Solver::NULL_WINDOW);
+    std::vector<std::vector<uint64_t>> levels(Position::WIDTH * Position::HEIGHT + 1 - minMoves);
+    for (size_t i = 0; i < positions.size(); i++) {
+        const Position &position = positions[i];
+        levels[position.nbMoves() - minMoves].push_back(OpeningBook::packEntry(position.canonicalKey(), solver.solve(position)));
+        if ((i + 1) % 100000 == 0) {
+            std::cerr << (i + 1) << " / " << positions.size() << " positions solved\n";
+        }
+    }
+
+    if (!EndgameTable::write(argv[2], levels, minMoves)) {
+        std::cerr << "Unable to write table \"" << argv[2] << "\"\n";
+        return 1;
+    }
+    return 0;
+}
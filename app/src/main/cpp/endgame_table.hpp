@@ -0,0 +1,224 @@
+#ifndef ENDGAME_TABLE_HPP
+#define ENDGAME_TABLE_HPP
+
+#include "board.hpp"
+#include "mapped_file.hpp"
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+namespace GameSolver { namespace Connect4 {
+
+        /**
+         * A read-only table of exact scores for late positions, probed by the solver so that searches
+         * reaching the table's positions stop there.
+         *
+         * A table file is made of a header, an index by number of moves and entries:
+         * - header: "C4EG" magic, format version, board width and height, smallest number of moves
+         *   of the positions and number of entries
+         * - index: for each number of moves from minMoves to WIDTH * HEIGHT, the position of its first
+         *   entry, followed by the number of entries
+         * - entries: in the OpeningBook layout, sorted by key within each number of moves
+         *
+         * A table does not hold every position with at least minMoves moves, only those reachable from
+         * the seed positions it was generated from, see endgame_generator. Positions are stored under
+         * Position::canonicalKey(). Positions the solver scores without searching, because the player
+         * to move can win or cannot avoid losing, are left out.
+         * Files use the native byte order.
+         *
+         * Tables are memory-mapped read-only like books, so every solver process of a host shares the
+         * pages of a table. A lookup is a binary search among the positions of a single number of moves.
+         */
+        class EndgameTable {
+        public:
+            static const uint32_t VERSION = 1;
+
+            struct Header {
+                char magic[4];      // "C4EG"
+                uint32_t version;   // VERSION
+                uint32_t width;     // Position::WIDTH of the table's positions
+                uint32_t height;    // Position::HEIGHT of the table's positions
+                uint32_t minMoves;  // smallest number of moves of the table's positions
+                uint32_t reserved;
+                uint64_t size;      // number of entries following the index
+            };
+
+            /**
+             * Writes a table file.
+             * @param path: path of the file to create.
+             * @param levels: entries built with OpeningBook::packEntry() for each number of moves from minMoves,
+             *                sorted in place by this function. Missing levels hold no entry.
+             * @param minMoves: smallest number of moves of the table's positions.
+             * @return true if the file was successfully written.
+             */
+            static bool write(const char *path, std::vector<std::vector<uint64_t>> &levels, unsigned int minMoves)
+            {
+                levels.resize(Position::WIDTH * Position::HEIGHT + 1 - minMoves);
+                std::vector<uint64_t> index;
+                index.reserve(levels.size() + 1);
+                uint64_t size = 0;
+                for(std::vector<uint64_t> &level : levels) {
+                    std::sort(level.begin(), level.end(), [](uint64_t a, uint64_t b) { return entryKey(a) < entryKey(b); });
+                    index.push_back(size);
+                    size += level.size();
+                }
+                index.push_back(size);
+
+                Header header;
+                std::memcpy(header.magic, "C4EG", 4);
+                header.version = VERSION;
+                header.width = Position::WIDTH;
+                header.height = Position::HEIGHT;
+                header.minMoves = minMoves;
+                header.reserved = 0;
+                header.size = size;
+
+                FILE *file = std::fopen(path, "wb");
+                if(!file) return false;
+                bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                          std::fwrite(index.data(), sizeof(uint64_t), index.size(), file) == index.size();
+                for(const std::vector<uint64_t> &level : levels) {
+                    ok = ok && (level.empty() || std::fwrite(level.data(), sizeof(uint64_t), level.size(), file) == level.size());
+                }
+                return std::fclose(file) == 0 && ok;
+            }
+
+            /**
+             * Opens a table file.
+             * @param path: path of the table file.
+             * @return true if the table was successfully opened.
+             */
+            bool open(const char *path)
+            {
+                close();
+                return file.open(path) && validate();
+            }
+
+            /**
+             * Closes the table, it then contains no position.
+             */
+            void close()
+            {
+                file.close();
+                opened = false;
+            }
+
+            /**
+             * @return true if a table is open.
+             */
+            bool isOpen() const
+            {
+                return opened;
+            }
+
+            /**
+             * @return the smallest number of moves of the table's positions, more than any position if no table is open.
+             */
+            unsigned int getMinMoves() const
+            {
+                return opened ? header.minMoves : Position::WIDTH * Position::HEIGHT + 1;
+            }
+
+            /**
+             * @return the number of positions of the table.
+             */
+            size_t size() const
+            {
+                return opened ? header.size : 0;
+            }
+
+            /**
+             * Looks up the score of a position.
+             * @param position: the position to look up.
+             * @param score: set to the exact score of the position if it is in the table.
+             * @return true if the position is in the table.
+             */
+            bool get(const Position &position, int &score) const
+            {
+                if(!opened || position.nbMoves() < header.minMoves) return false;
+                unsigned int level = position.nbMoves() - header.minMoves;
+                uint64_t key = position.canonicalKey();
+                uint64_t first = indexEntry(level), end = indexEntry(level + 1);
+                uint64_t count = end - first;
+                while(count > 0) {
+                    uint64_t half = count / 2;
+                    if(entryKey(entry(first + half)) < key) {
+                        first += half + 1;
+                        count -= half + 1;
+                    } else {
+                        count = half;
+                    }
+                }
+                if(first == end || entryKey(entry(first)) != key) return false;
+                score = static_cast<int8_t>(entry(first) >> 56);
+                return true;
+            }
+
+            /**
+             * Default constructor, build an empty table.
+             */
+            EndgameTable() : header(), levels{0}, opened{false} {}
+
+        private:
+            MappedFile file;  // memory mapping of the table file
+            Header header;    // copy of the header of the table
+            size_t levels;    // number of moves covered by the table
+            bool opened;      // whether a valid table is mapped
+
+            // return the rank of the first entry of a given level of the index, which follows the header in the mapping
+            uint64_t indexEntry(size_t level) const
+            {
+                return file.read<uint64_t>(sizeof(Header) + level * sizeof(uint64_t));
+            }
+
+            // return the entry of a given rank, the entries follow the index in the mapping
+            uint64_t entry(uint64_t rank) const
+            {
+                return file.read<uint64_t>(sizeof(Header) + (levels + 1 + rank) * sizeof(uint64_t));
+            }
+
+            static uint64_t entryKey(uint64_t entry)
+            {
+                return entry & ((UINT64_C(1) << 56) - 1);
+            }
+
+            /**
+             * Checks the header and index of the mapped file.
+             * @return true if the file is a table of the board, it is closed otherwise.
+             */
+            bool validate()
+            {
+                if(file.size() < sizeof(Header)) {
+                    close();
+                    return false;
+                }
+                Header h = file.read<Header>(0);
+                if(std::memcmp(h.magic, "C4EG", 4) != 0 || h.version != VERSION ||
+                   h.width != Position::WIDTH || h.height != Position::HEIGHT ||
+                   h.minMoves > Position::WIDTH * Position::HEIGHT) {
+                    close();
+                    return false;
+                }
+                levels = Position::WIDTH * Position::HEIGHT + 1 - h.minMoves;
+                size_t capacity = (file.size() - sizeof(Header)) / sizeof(uint64_t);
+                if(capacity < levels + 1 || h.size > capacity - levels - 1 || indexEntry(levels) != h.size) {
+                    close();
+                    return false;
+                }
+                for(size_t level = 0; level < levels; level++) {
+                    if(indexEntry(level) > indexEntry(level + 1)) {
+                        close();
+                        return false;
+                    }
+                }
+                header = h;
+                opened = true;
+                return true;
+            }
+        };
+
+    }} // end namespaces
+
+#endif
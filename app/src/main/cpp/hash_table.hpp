@@ -1,139 +1,654 @@
 #ifndef HASH_TABLE_HPP
 #define HASH_TABLE_HPP
 
-#include <array>
+#include "mapped_file.hpp"
+#include <atomic>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
 #include <algorithm>
 #include <cassert>
+#include <type_traits>
+#include <sys/mman.h>
+
+/**
+ * Whether TranspositionTable counts its lookups and stores by default, for debug builds only.
+ * Define it to 1 to count them in release builds too, the same way for every translation unit.
+ */
+#ifndef TRANSPOSITION_TABLE_STATS
+#ifdef NDEBUG
+#define TRANSPOSITION_TABLE_STATS 0
+#else
+#define TRANSPOSITION_TABLE_STATS 1
+#endif
+#endif
+
+/**
+ * Whether TranspositionTable asks Linux to back large tables with transparent huge pages, so that
+ * probes spread over the table do not also miss the TLB. Other systems ignore it.
+ */
+#ifndef TRANSPOSITION_TABLE_HUGE_PAGES
+#define TRANSPOSITION_TABLE_HUGE_PAGES 1
+#endif
+
+/**
+ * @brief Selects the smallest unsigned integer type able to store a given number of bits.
+ */
+template<unsigned Bits>
+struct uint_t {
+    static_assert(Bits <= 64, "Integers are limited to 64 bits");
+    typedef typename std::conditional<Bits <= 8, uint8_t,
+            typename std::conditional<Bits <= 16, uint16_t,
+            typename std::conditional<Bits <= 32, uint32_t, uint64_t>::type>::type>::type type;
+};
 
 /**
  * @brief A simple transposition table for caching game tree analysis results.
+ *
+ * The table is allocated and sized at construction from a memory budget, it never
+ * allocates afterwards. Its memory is mapped by the table, or placed in memory given
+ * by the caller, e.g. an arena shared by several tables.
+ * The number of entries is rounded down to a power of two so that indexing
+ * can use a bit mask instead of a modulo.
+ *
+ * The table is lossy: every key has a single slot and storing a key always
+ * replaces the previous entry of its slot. Lookups and stores therefore cost
+ * one probe regardless of how full the table is.
+ *
+ * Only a partial key is stored in each slot. Keys are first scrambled by a
+ * bijection of the FullKeySize bits key space. The top bits of the scrambled
+ * key select the slot and the low KeySize bits are stored as partial key, so
+ * as long as KeySize + log2(size) >= FullKeySize the (slot, partial key) pair
+ * still identifies a single key and the table never returns a wrong entry.
+ * Smaller tables only verify KeySize + log2(size) bits of the key.
+ *
+ * Entries are grouped by consecutive slots into buckets of one 64 bytes cache line, aligned
+ * on cache lines, so that a probe reads and writes a single line. prefetch() loads the line
+ * of a key ahead of its probe. Buckets hold packed arrays of partial keys, values and
+ * generations of a power of two number of entries, e.g. 8 entries of a 32 bits partial key
+ * and a 16 bits value, which take 56 bytes and leave 8 bytes of padding.
+ *
+ * Each entry is tagged with the generation of the table when it was stored. clear()
+ * starts a new generation in constant time: entries of older generations read as
+ * missing and are lazily overwritten by later stores, so a long-lived table can be
+ * emptied between unrelated queries without touching its memory.
+ *
+ * The entries of the current generation can be saved to a file and loaded back by a later
+ * process, see save(). A saved file can also be memory-mapped read-only as a snapshot that
+ * lookups fall back to when the table misses, see mapSnapshot(): processes sharing a
+ * snapshot share its pages and start with a warm table without copying it.
+ *
+ * With CountStats the table counts its lookups and stores, see getStats(). Counters are
+ * plain relaxed loads and stores: threads racing on them may lose a few increments.
+ * Without CountStats the counting code compiles away.
+ *
+ * The table can be shared by several search threads without locks. Each slot is
+ * accessed with relaxed atomic loads and stores, and the key array holds the partial
+ * key xor-ed with a hash of the value ("lockless hashing"): when a reader sees the
+ * key of one store and the value of a concurrent one, the check fails and the slot
+ * reads as missing instead of returning a value that belongs to another key.
+ *
+ * @tparam KeySize number of bits of the partial keys stored in the table.
+ * @tparam ValueSize number of bits of the values stored in the table.
+ * @tparam FullKeySize number of significant bits of the keys given to the table.
+ * @tparam CountStats whether to count lookups and stores.
  */
+template<unsigned KeySize = 32, unsigned ValueSize = 8, unsigned FullKeySize = 56,
+         bool CountStats = TRANSPOSITION_TABLE_STATS>
 class TranspositionTable {
+public:
+    typedef typename uint_t<KeySize>::type key_t;      // Type of the stored partial keys
+    typedef typename uint_t<ValueSize>::type value_t;  // Type of the stored values
+
+    /**
+     * @brief Usage of the table since it was built or since the last reset() or resetStats().
+     * All the counters are 0 when the table does not count its stats.
+     */
+    struct Stats {
+        static constexpr bool COUNTED = CountStats;  // Whether the counters are actual counts
+
+        size_t hits;          // Lookups finding their key
+        size_t misses;        // Lookups not finding their key
+        size_t stores;        // Calls to put()
+        size_t replacements;  // Stores overwriting the entry of another key of the current generation
+        size_t probes;        // Slots read by the lookups
+        size_t occupied;      // Entries of the current generation, counted when the stats are taken
+        size_t size;          // Number of entries of the table
+
+        double hitRate() const {
+            return hits + misses > 0 ? static_cast<double>(hits) / (hits + misses) : 0.0;
+        }
+
+        double replacementRate() const {
+            return stores > 0 ? static_cast<double>(replacements) / stores : 0.0;
+        }
+
+        double occupancy() const {
+            return size > 0 ? static_cast<double>(occupied) / size : 0.0;
+        }
+
+        double meanProbeLength() const {
+            return hits + misses > 0 ? static_cast<double>(probes) / (hits + misses) : 0.0;
+        }
+    };
+
+    /**
+     * @brief Header of the files written by save(), followed by the partial keys and then the values
+     * of the entries, in native byte order. Entries missing from the table are saved as zeros.
+     */
+    struct SnapshotHeader {
+        char magic[4];         // "C4TT"
+        uint32_t version;      // SNAPSHOT_VERSION
+        uint32_t keySize;      // KeySize of the table
+        uint32_t valueSize;    // ValueSize of the table
+        uint32_t fullKeySize;  // FullKeySize of the table
+        uint32_t logSize;      // log2 of the number of entries
+        uint32_t format;       // Meaning of the keys and values given by the user of the table, e.g. its board
+        uint32_t reserved;
+    };
+
+    static const uint32_t SNAPSHOT_VERSION = 1;
+
 private:
+    static_assert(KeySize <= FullKeySize, "Partial keys cannot be larger than full keys");
+    static_assert(FullKeySize < 64, "Keys must fit within 63 bits");
+
+    static constexpr uint64_t FULL_KEY_MASK = (UINT64_C(1) << FullKeySize) - 1;  // Mask of the significant key bits
+    static constexpr uint64_t PARTIAL_KEY_MASK = (UINT64_C(1) << KeySize) - 1;   // Mask of the stored key bits
+
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr size_t ENTRY_SIZE = sizeof(key_t) + sizeof(value_t) + sizeof(uint8_t);  // Bytes of an entry in the arrays of a bucket
+    static_assert(ENTRY_SIZE <= CACHE_LINE_SIZE, "Entries must fit in a cache line");
+
+    static constexpr unsigned logBucketEntries(unsigned log = 0) {
+        return (size_t(2) << log) * ENTRY_SIZE <= CACHE_LINE_SIZE ? logBucketEntries(log + 1) : log;
+    }
+
+    static constexpr unsigned LOG_BUCKET_ENTRIES = logBucketEntries();  // log2 of the number of entries of a bucket
+    static constexpr size_t BUCKET_ENTRIES = size_t(1) << LOG_BUCKET_ENTRIES;
+
     /**
-     * @brief Represents an entry in the transposition table.
+     * @brief The entries of BUCKET_ENTRIES consecutive slots, in one cache line.
      */
-    struct Entry {
-        uint64_t key : 56;  // 56-bit key to uniquely identify a position
-        uint8_t upperBound; // 8-bit upper bound value for the position
+    struct alignas(CACHE_LINE_SIZE) Bucket {
+        std::atomic<key_t> K[BUCKET_ENTRIES];    // Partial keys xor-ed with valueCheck()
+        std::atomic<value_t> V[BUCKET_ENTRIES];  // Values, stored separately so that entries are not padded
+        std::atomic<uint8_t> G[BUCKET_ENTRIES];  // Generation of each entry, 0 for entries never stored since reset()
     };
+    static_assert(sizeof(Bucket) == CACHE_LINE_SIZE, "Buckets must take one cache line");
+
+    static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;  // Alignment of the tables backed by huge pages
+
+    Bucket *buckets;         // Buckets of the entries, aligned on cache lines
+    size_t bucketCount;      // Number of buckets, of at least one entry each
+    size_t mappingSize;      // Bytes of the mapping holding the buckets, 0 in memory of the caller
+    size_t size;             // Number of entries, a power of two
+    uint8_t generation;      // Generation of the entries stored now, never 0
+    unsigned indexShift;     // FullKeySize - log2(size), selects the slot bits of a scrambled key
+
+    // Read-only snapshot consulted by get() when the table misses, see mapSnapshot()
+    GameSolver::Connect4::MappedFile snapshot;
+    const key_t *snapshotKeys = nullptr;      // Partial keys of the snapshot, nullptr if none is mapped
+    const value_t *snapshotValues = nullptr;  // Values of the snapshot
 
-    static constexpr size_t TABLE_SIZE = 128;  // Set your desired table size
-    static constexpr uint64_t KEY_MASK = (1ULL << 56) - 1;  // Mask to ensure key fits within 56 bits
+    // Counters of getStats(), only updated with CountStats
+    mutable std::atomic<size_t> hits;
+    mutable std::atomic<size_t> misses;
+    std::atomic<size_t> stores;
+    std::atomic<size_t> replacements;
+    mutable std::atomic<size_t> probes;
 
-    std::array<Entry, TABLE_SIZE> T;  // Array to store entries
+    /**
+     * @brief Increments a counter of getStats() if the table counts its stats.
+     */
+    static void count(std::atomic<size_t> &counter) noexcept {
+        if (CountStats) {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+
+    // Arrays of the slot of index i
+    std::atomic<key_t> &K(size_t i) const noexcept {
+        return buckets[i >> LOG_BUCKET_ENTRIES].K[i & (BUCKET_ENTRIES - 1)];
+    }
+
+    std::atomic<value_t> &V(size_t i) const noexcept {
+        return buckets[i >> LOG_BUCKET_ENTRIES].V[i & (BUCKET_ENTRIES - 1)];
+    }
+
+    std::atomic<uint8_t> &G(size_t i) const noexcept {
+        return buckets[i >> LOG_BUCKET_ENTRIES].G[i & (BUCKET_ENTRIES - 1)];
+    }
 
-    size_t collisions;
-    size_t totalQueries;
+    /**
+     * @brief Tells whether a slot holds an entry of the current generation for a partial key.
+     */
+    bool matches(size_t i, key_t partialKey) const noexcept {
+        key_t k = K(i).load(std::memory_order_relaxed);
+        value_t val = V(i).load(std::memory_order_relaxed);
+        return (k ^ valueCheck(val)) == partialKey && G(i).load(std::memory_order_relaxed) == generation;
+    }
+
+    /**
+     * @brief Scrambles a key with a bijection of the key space.
+     * Multiplications by odd constants and xor-shifts are invertible modulo 2^FullKeySize,
+     * so two different keys always give two different scrambled keys.
+     * @param key The key to scramble, fitting within FullKeySize bits.
+     * @return The scrambled key, fitting within FullKeySize bits.
+     */
+    static uint64_t scramble(uint64_t key) noexcept {
+        key = (key * 0x165667919E3779F9ULL) & FULL_KEY_MASK;
+        key ^= (key >> (FullKeySize / 2));
+        key = (key * 0x9E3779B97F4A7C15ULL) & FULL_KEY_MASK;
+        return key;
+    }
 
     /**
-     * @brief Computes the index in the transposition table for a given key.
-     * @param key The 56-bit key to compute the index for.
+     * @brief Hashes a value into the key space to detect keys and values written by two different stores.
+     * Multiplying by an odd constant keeps distinct values distinct.
+     */
+    static key_t valueCheck(value_t val) noexcept {
+        return static_cast<key_t>(val * 0x9E3779B97F4A7C15ULL);
+    }
+
+    /**
+     * @brief Computes the index in the transposition table for a scrambled key.
+     * Each key maps to exactly one slot, so a lookup is a single probe.
+     * @param scrambledKey The scrambled key to compute the index for.
      * @return The computed index.
      */
-    size_t index(uint64_t key) const {
-        // Use double hashing for collision resolution
-        size_t hash1 = hashFunction1(key);
-        size_t hash2 = hashFunction2(key);
+    size_t index(uint64_t scrambledKey) const noexcept {
+        return static_cast<size_t>(scrambledKey >> indexShift);
+    }
 
-        size_t index = hash1;
+    /**
+     * @brief Computes the number of buckets holding a number of entries, at least one.
+     */
+    static size_t bucketsFor(unsigned logEntries) {
+        return logEntries > LOG_BUCKET_ENTRIES ? size_t(1) << (logEntries - LOG_BUCKET_ENTRIES) : 1;
+    }
 
-        // Handle collisions using linear probing
-        while (T[index].key != 0 && T[index].key != key) {
-            // Linear probing with double hashing
-            index = (index + hash2) % TABLE_SIZE;
+    /**
+     * @brief Computes the largest power of two number of entries fitting in a memory budget.
+     * @param budgetBytes The memory budget in bytes, tables always take at least one bucket.
+     * @return The log2 of the number of entries, at least 0.
+     */
+    static unsigned logEntriesForBudget(size_t budgetBytes) {
+        unsigned logEntries = 0;
+        while (logEntries < FullKeySize && bucketsFor(logEntries + 1) <= budgetBytes / sizeof(Bucket)) {
+            logEntries++;
         }
+        return logEntries;
+    }
 
-        return index;
+    /**
+     * @brief Computes the bytes of a budget left for the buckets once aligned on a cache line.
+     * @param memory The memory of the caller holding the budget, or nullptr for memory mapped by the table.
+     */
+    static size_t alignedBudget(size_t budgetBytes, void *memory) {
+        size_t offset = memory ? (CACHE_LINE_SIZE - reinterpret_cast<uintptr_t>(memory) % CACHE_LINE_SIZE) % CACHE_LINE_SIZE : 0;
+        return budgetBytes > offset ? budgetBytes - offset : 0;
     }
 
-    size_t hashFunction1(uint64_t key) const {
-        key ^= (key >> 21);
-        key ^= (key << 37);
-        key ^= (key >> 4);
-        key *= 0x165667919E3779F9ULL;
+    /**
+     * @brief Places the buckets in memory of the caller, aligned on a cache line.
+     * @throw std::bad_alloc if the memory cannot hold a bucket.
+     */
+    void place(void *memory, size_t budgetBytes) {
+        if (alignedBudget(budgetBytes, memory) < sizeof(Bucket)) {
+            throw std::bad_alloc();
+        }
+        mappingSize = 0;
+        buckets = reinterpret_cast<Bucket*>(static_cast<char*>(memory) + (budgetBytes - alignedBudget(budgetBytes, memory)));
+        for (size_t b = 0; b < bucketCount; b++) {
+            new (&buckets[b]) Bucket;
+        }
+    }
 
-        return key % TABLE_SIZE;
+    /**
+     * @brief Maps the memory of the buckets, aligned on huge pages when the table is backed by them.
+     * @throw std::bad_alloc if the memory cannot be mapped.
+     */
+    void allocate() {
+        size_t bytes = bucketCount * sizeof(Bucket);
+#if TRANSPOSITION_TABLE_HUGE_PAGES && defined(MADV_HUGEPAGE)
+        bool hugePages = bytes >= HUGE_PAGE_SIZE;
+#else
+        bool hugePages = false;
+#endif
+        mappingSize = hugePages ? bytes + HUGE_PAGE_SIZE : bytes;  // Room to align the buckets on a huge page
+        void *memory = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        char *start = static_cast<char*>(memory);
+#if TRANSPOSITION_TABLE_HUGE_PAGES && defined(MADV_HUGEPAGE)
+        if (hugePages) {
+            char *aligned = start + (HUGE_PAGE_SIZE - reinterpret_cast<uintptr_t>(start) % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+            if (aligned > start) {
+                munmap(start, aligned - start);
+            }
+            munmap(aligned + bytes, start + mappingSize - aligned - bytes);
+            start = aligned;
+            mappingSize = bytes;
+            madvise(start, bytes, MADV_HUGEPAGE);  // Only a hint, ignored where huge pages are disabled
+        }
+#endif
+        buckets = reinterpret_cast<Bucket*>(start);  // Mappings start on page boundaries, thus on cache lines
+        for (size_t b = 0; b < bucketCount; b++) {
+            new (&buckets[b]) Bucket;
+        }
     }
 
-    size_t hashFunction2(uint64_t key) const {
-        key ^= (key >> 37);
-        key ^= (key << 21);
-        key ^= (key >> 35);
-        key *= 0x9E3779B97F4A7C15ULL;
+    SnapshotHeader snapshotHeader(uint32_t format) const {
+        SnapshotHeader header;
+        std::memcpy(header.magic, "C4TT", 4);
+        header.version = SNAPSHOT_VERSION;
+        header.keySize = KeySize;
+        header.valueSize = ValueSize;
+        header.fullKeySize = FullKeySize;
+        header.logSize = FullKeySize - indexShift;
+        header.format = format;
+        header.reserved = 0;
+        return header;
+    }
+
+    /**
+     * @brief Tells whether a mapped file is a snapshot of a table of the same geometry and size.
+     */
+    bool isSnapshot(const GameSolver::Connect4::MappedFile &file, uint32_t format) const {
+        SnapshotHeader expected = snapshotHeader(format);
+        return file.size() == sizeof(SnapshotHeader) + size * (sizeof(key_t) + sizeof(value_t)) &&
+               std::memcmp(file.data(), &expected, sizeof(expected)) == 0;
+    }
 
-        return 1 + (key % (TABLE_SIZE - 1));
+    /**
+     * @brief Writes an array of the entries of the current generation in slot order, by chunks.
+     * @param array The array of the buckets to write, Bucket::K or Bucket::V.
+     */
+    template<class T>
+    bool writeSnapshotArray(FILE *file, std::atomic<T> (Bucket::*array)[BUCKET_ENTRIES]) const {
+        T chunk[4096];
+        for (size_t i = 0; i < size; i += 4096) {
+            size_t n = std::min<size_t>(4096, size - i);
+            for (size_t j = 0; j < n; j++) {
+                const Bucket &bucket = buckets[(i + j) >> LOG_BUCKET_ENTRIES];
+                size_t e = (i + j) & (BUCKET_ENTRIES - 1);
+                chunk[j] = bucket.G[e].load(std::memory_order_relaxed) == generation ? (bucket.*array)[e].load(std::memory_order_relaxed) : 0;
+            }
+            if (std::fwrite(chunk, sizeof(T), n, file) != n) {
+                return false;
+            }
+        }
+        return true;
     }
 
 public:
+    static constexpr size_t DEFAULT_BUDGET_BYTES = 8 << 20;  // 8 MB, suitable for phones
+
     /**
-     * @brief Constructs a TranspositionTable with a fixed size.
+     * @brief Constructs a TranspositionTable using at most a given amount of memory.
+     * @param budgetBytes The memory budget in bytes, e.g. 8 MB on phones or several GB on servers.
+     * @param memory Memory of budgetBytes bytes given by the caller to hold the table, which must outlive
+     *               the table, or nullptr for the table to map its own memory.
+     * @throw std::bad_alloc if the memory cannot be mapped, or the memory of the caller cannot hold a bucket.
      */
-    TranspositionTable() : collisions(0), totalQueries(0) {
+    explicit TranspositionTable(size_t budgetBytes = DEFAULT_BUDGET_BYTES, void *memory = nullptr)
+            : bucketCount(bucketsFor(logEntriesForBudget(alignedBudget(budgetBytes, memory)))),
+              size(size_t(1) << logEntriesForBudget(alignedBudget(budgetBytes, memory))),
+              indexShift(FullKeySize - logEntriesForBudget(alignedBudget(budgetBytes, memory))) {
+        if (memory) {
+            place(memory, budgetBytes);
+        } else {
+            allocate();
+        }
         reset();
     }
 
+    ~TranspositionTable() {
+        if (mappingSize) {
+            munmap(buckets, mappingSize);
+        }
+    }
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
     /**
-     * @brief Resets the transposition table by filling it with zeroed entries.
+     * @brief Resets the transposition table by filling it with zeroed entries, and resets its stats.
      */
     void reset() {
-        std::fill(T.begin(), T.end(), Entry{0, 0});  // Fill the entire table with zeroed entries
+        for (size_t i = 0; i < size; i++) {  // Fill the entire table with zeroed entries
+            K(i).store(0, std::memory_order_relaxed);
+            V(i).store(0, std::memory_order_relaxed);
+            G(i).store(0, std::memory_order_relaxed);
+        }
+        generation = 1;
+        resetStats();
     }
 
+    /**
+     * @brief Resets the counters of getStats(), keeping the entries.
+     * Must not be called concurrently with put() and get().
+     */
+    void resetStats() {
+        hits.store(0, std::memory_order_relaxed);
+        misses.store(0, std::memory_order_relaxed);
+        stores.store(0, std::memory_order_relaxed);
+        replacements.store(0, std::memory_order_relaxed);
+        probes.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Empties the transposition table in constant time by starting a new generation.
+     * Once every 255 calls the generation counter wraps around and the table is reset(),
+     * so that entries of an old generation never come back. The stats are kept, except on reset().
+     * Must not be called concurrently with put() and get().
+     */
+    void clear() {
+        if (++generation == 0) {
+            reset();
+        }
+    }
+
+    /**
+     * @return The number of entries of the table.
+     */
+    size_t getSize() const {
+        return size;
+    }
+
+    /**
+     * @return The memory used by the buckets of the table in bytes, at most the budget of the constructor unless it cannot hold a bucket.
+     */
+    size_t getMemoryUsage() const {
+        return bucketCount * sizeof(Bucket);
+    }
+
+    /**
+     * @brief Takes the stats of the table. Occupancy is counted over the whole table, in linear time.
+     * Must not be called concurrently with put() and get().
+     */
+    Stats getStats() const {
+        Stats stats = {hits.load(std::memory_order_relaxed), misses.load(std::memory_order_relaxed),
+                       stores.load(std::memory_order_relaxed), replacements.load(std::memory_order_relaxed),
+                       probes.load(std::memory_order_relaxed), 0, size};
+        if (CountStats) {
+            for (size_t i = 0; i < size; i++) {
+                stats.occupied += G(i).load(std::memory_order_relaxed) == generation;
+            }
+        }
+        return stats;
+    }
+
+    /**
+     * @return The number of stores overwriting the entry of another key, see getStats().
+     */
     size_t getCollisions() const {
-        return collisions;
+        return replacements.load(std::memory_order_relaxed);
     }
 
+    /**
+     * @return The number of lookups and stores, see getStats().
+     */
     size_t getTotalQueries() const {
-        return totalQueries;
+        return hits.load(std::memory_order_relaxed) + misses.load(std::memory_order_relaxed) +
+               stores.load(std::memory_order_relaxed);
     }
 
+    /**
+     * @return The share of lookups and stores overwriting the entry of another key.
+     */
     double getCollisionRate() const {
-        return (totalQueries > 0) ? static_cast<double>(collisions) / totalQueries : 0.0;
+        size_t totalQueries = getTotalQueries();
+        return (totalQueries > 0) ? static_cast<double>(getCollisions()) / totalQueries : 0.0;
     }
 
     /**
-     * @brief Stores a value in the transposition table for a given key.
-     * @param key The 56-bit key.
-     * @param val The 8-bit value to store.
-     * @param isUpperBound Indicates if the value is an upper bound.
+     * @brief Saves the entries of the current generation to a file, see SnapshotHeader.
+     * The file is written under a temporary name and then renamed, so that processes mapping the
+     * previous file keep reading it. Safe to call concurrently with put() and get(): entries stored
+     * meanwhile may or may not be saved, and entries torn by a concurrent store read as missing.
+     * @param path The path of the file.
+     * @param format Meaning of the keys and values, which load() and mapSnapshot() expect.
+     * @return true if the file was successfully written.
      */
-    void put(uint64_t key, uint8_t val, bool isUpperBound) {
-        assert(key < KEY_MASK);  // Ensure the key fits within the specified 56 bits
-        size_t i = index(key);
+    bool save(const char *path, uint32_t format = 0) const {
+        std::string temporaryPath = std::string(path) + ".tmp";
+        FILE *file = std::fopen(temporaryPath.c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+        SnapshotHeader header = snapshotHeader(format);
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  writeSnapshotArray(file, &Bucket::K) && writeSnapshotArray(file, &Bucket::V);
+        ok = std::fclose(file) == 0 && ok && std::rename(temporaryPath.c_str(), path) == 0;
+        if (!ok) {
+            std::remove(temporaryPath.c_str());
+        }
+        return ok;
+    }
 
-        // Update the entry if it already exists
-        if (T[i].key == key) {
-            const_cast<uint8_t&>(T[i].upperBound) = val; // Update the upper bound value
-        } else {
-            // Otherwise, insert a new entry
-            T[i] = {key, val};  // Create a new entry with the provided key and value
+    /**
+     * @brief Replaces the entries of the table with the entries saved by save() from a table of the
+     * same geometry, size and format. The stats are reset.
+     * Must not be called concurrently with put() and get().
+     * @return true if the file was loaded, the table is unchanged otherwise.
+     */
+    bool load(const char *path, uint32_t format = 0) {
+        GameSolver::Connect4::MappedFile file;
+        if (!file.open(path) || !isSnapshot(file, format)) {
+            return false;
+        }
+        reset();
+        const key_t *keys = reinterpret_cast<const key_t*>(file.data() + sizeof(SnapshotHeader));
+        const value_t *values = reinterpret_cast<const value_t*>(keys + size);
+        for (size_t i = 0; i < size; i++) {
+            K(i).store(keys[i], std::memory_order_relaxed);
+            V(i).store(values[i], std::memory_order_relaxed);
+            G(i).store(values[i] ? generation : 0, std::memory_order_relaxed);
         }
+        return true;
+    }
 
+    /**
+     * @brief Maps a file saved by save() from a table of the same geometry, size and format as a read-only
+     * snapshot: get() returns the entry of the snapshot when the table has none for the key. Pages of the
+     * snapshot are loaded on demand and shared with the other processes mapping it.
+     * The snapshot is kept by clear() and reset(), it is never written.
+     * Must not be called concurrently with put() and get().
+     * @return true if the file was mapped, the previous snapshot is unmapped in any case.
+     */
+    bool mapSnapshot(const char *path, uint32_t format = 0) {
+        unmapSnapshot();
+        if (!snapshot.open(path) || !isSnapshot(snapshot, format)) {
+            snapshot.close();
+            return false;
+        }
+        snapshotKeys = reinterpret_cast<const key_t*>(snapshot.data() + sizeof(SnapshotHeader));
+        snapshotValues = reinterpret_cast<const value_t*>(snapshotKeys + size);
+        return true;
     }
 
     /**
-     * @brief Retrieves the value for a given key from the transposition table.
-     * @param key The 56-bit key.
-     * @param isUpperBound Output parameter indicating if the value is an upper bound.
-     * @return The 8-bit value associated with the key if present, 0 otherwise.
+     * @brief Unmaps the snapshot of mapSnapshot(), if any.
+     * Must not be called concurrently with put() and get().
      */
-    uint8_t get(uint64_t key) const {
-        assert(key < KEY_MASK);  // Ensure the key fits within the specified 56 bits
-        size_t i = index(key);
+    void unmapSnapshot() {
+        snapshot.close();
+        snapshotKeys = nullptr;
+        snapshotValues = nullptr;
+    }
 
-        // Search for the key in the table
-        while (T[i].key != 0) {
+    /**
+     * @brief Starts loading the bucket of a key into the cache, so that a following get() or put() of the
+     * key does not wait for memory. Searches call it for the children of a node before searching them.
+     * @param key The FullKeySize-bit key.
+     */
+    void prefetch(uint64_t key) const noexcept {
+#if defined(__GNUC__)
+        __builtin_prefetch(&buckets[index(scramble(key)) >> LOG_BUCKET_ENTRIES]);
+#else
+        (void)key;
+#endif
+    }
 
-            if (T[i].key == key) {
-                return T[i].upperBound;
+    /**
+     * @brief Stores a value in the transposition table for a given key.
+     * Any previous entry using the same slot is overwritten, whatever its generation.
+     * Safe to call concurrently with put() and get() from other threads.
+     * @param key The FullKeySize-bit key.
+     * @param val The ValueSize-bit value to store, 0 is reserved for missing entries.
+     */
+    void put(uint64_t key, value_t val) noexcept {
+        assert(key <= FULL_KEY_MASK);  // Ensure the key fits within the specified bits
+        uint64_t scrambledKey = scramble(key);
+        size_t i = index(scrambledKey);
+        if (CountStats) {
+            count(stores);
+            if (G(i).load(std::memory_order_relaxed) == generation &&
+                !matches(i, static_cast<key_t>(scrambledKey & PARTIAL_KEY_MASK))) {
+                count(replacements);
+            }
+        }
+        V(i).store(val, std::memory_order_relaxed);  // Always replace
+        G(i).store(generation, std::memory_order_relaxed);
+        K(i).store(static_cast<key_t>((scrambledKey & PARTIAL_KEY_MASK) ^ valueCheck(val)), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Retrieves the value for a given key from the transposition table, or from the snapshot
+     * of mapSnapshot() when the table has no entry for the key.
+     * Safe to call concurrently with put() and get() from other threads.
+     * @param key The FullKeySize-bit key.
+     * @return The value associated with the key if present, 0 otherwise.
+     */
+    value_t get(uint64_t key) const noexcept {
+        assert(key <= FULL_KEY_MASK);  // Ensure the key fits within the specified bits
+        uint64_t scrambledKey = scramble(key);
+        size_t i = index(scrambledKey);
+        count(probes);
+
+        key_t partialKey = static_cast<key_t>(scrambledKey & PARTIAL_KEY_MASK);
+        key_t k = K(i).load(std::memory_order_relaxed);
+        value_t val = V(i).load(std::memory_order_relaxed);
+        if ((k ^ valueCheck(val)) == partialKey && G(i).load(std::memory_order_relaxed) == generation) {
+            count(hits);
+            return val;
+        }
+        if (snapshotValues) {
+            val = snapshotValues[i];
+            if (val && (snapshotKeys[i] ^ valueCheck(val)) == partialKey) {
+                count(hits);
+                return val;
             }
-            i = (i + 1) % TABLE_SIZE;
         }
 
-        return 0;  // Key not found
+        count(misses);
+        return 0;  // Key not found, its entry has been replaced or belongs to an older generation
     }
 };
 
-#endif
\ No newline at end of file
+#endif
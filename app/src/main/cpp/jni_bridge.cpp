@@ -0,0 +1,367 @@
+#include "solver.hpp"
+#include "opening_book.hpp"
+#include <jni.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace GameSolver::Connect4;
+
+namespace {
+
+    /**
+     * Native state of a com.example.connect4.Connect4Engine: the current game and a solver kept for the
+     * whole game session, so that its TranspositionTable stays warm from one move to the next.
+     *
+     * Searches, and the loads and saves of the cache, run on a worker thread owned by the session, the only
+     * thread using the solver. A search works on a copy of the position taken when it is requested, so moves
+     * can be played while it runs. Results are reported to a Kotlin listener from the worker thread.
+     */
+    class Session {
+    public:
+        explicit Session(JavaVM *vm) : vm(vm), worker(&Session::run, this) {
+            solver.setCancelFlag(&cancelled);
+        }
+
+        /**
+         * Cancels the current search, completes a pending saveCache() and stops the worker thread.
+         * @param env The JNI environment of the calling thread.
+         */
+        void close(JNIEnv *env) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+                cancelled.store(true, std::memory_order_relaxed);
+                dropRequest(env);
+            }
+            wakeUp.notify_one();
+            worker.join();
+        }
+
+        /**
+         * Plays a move of the game.
+         * A winning move ends the game: it stays in the history of the game, but no other move can be played.
+         * @param column The column of the move, from 0 for the leftmost one.
+         * @return false if the move cannot be played.
+         */
+        bool play(int column) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (gameOver || column < 0 || column >= Position::WIDTH || !position.canPlay(column)) {
+                return false;
+            }
+            if (position.isWinningMove(column)) {
+                gameOver = true;  // Position does not hold alignments
+            } else {
+                position.play(column);
+            }
+            moves[moveCount++] = column;
+            return true;
+        }
+
+        /**
+         * Takes back the last move of the game.
+         * @return false if no move has been played.
+         */
+        bool undo() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (moveCount == 0) {
+                return false;
+            }
+            moveCount--;
+            if (gameOver) {
+                gameOver = false;  // The winning move was never played on the position
+            } else {
+                position.undo(moves[moveCount]);
+            }
+            return true;
+        }
+
+        /**
+         * Starts a new game. The results of the previous searches are kept, they remain valid.
+         */
+        void newGame() {
+            std::lock_guard<std::mutex> lock(mutex);
+            position = Position();
+            moveCount = 0;
+            gameOver = false;
+        }
+
+        int getMoveCount() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return moveCount;
+        }
+
+        bool isWinningMove(int column) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return !gameOver && column >= 0 && column < Position::WIDTH &&
+                   position.canPlay(column) && position.isWinningMove(column);
+        }
+
+        /**
+         * Opens the opening book shipped as an uncompressed asset.
+         * @return false if the book cannot be opened, or a search is running or requested.
+         */
+        bool openBook(int fd, off_t offset, size_t length) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (busy || request) {
+                return false;
+            }
+            solver.setOpeningBook(nullptr);
+            if (!book.open(fd, offset, length)) {
+                return false;
+            }
+            solver.setOpeningBook(&book);
+            return true;
+        }
+
+        /**
+         * Requests loading the results of the searches of a previous session saved by saveCache().
+         * The file is read by the worker thread before the following searches, not by the calling thread.
+         * A file that cannot be loaded leaves the results of the session as they are.
+         */
+        void loadCache(const char *path) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                loadPath = path;
+            }
+            wakeUp.notify_one();
+        }
+
+        /**
+         * Requests saving the results of the searches for the next session, see Connect4Solver::saveCache().
+         * The file is written by the worker thread once the running search, if any, completes and before the
+         * following searches. A save still pending when the session is closed is done before it closes.
+         */
+        void saveCache(const char *path) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                savePath = path;
+            }
+            wakeUp.notify_one();
+        }
+
+        /**
+         * Requests the analysis of the current position, cancelling the running search if any.
+         * @param env The JNI environment of the calling thread.
+         * @param listener The Kotlin object receiving the results.
+         * @param timeLimitMillis The time limit of the search.
+         * @return false if the game is over.
+         */
+        bool analyze(JNIEnv *env, jobject listener, jlong timeLimitMillis) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (gameOver) {
+                    return false;
+                }
+                dropRequest(env);
+                request = env->NewGlobalRef(listener);
+                requestPosition = position;
+                requestTimeLimit = std::chrono::milliseconds(timeLimitMillis);
+                cancelled.store(true, std::memory_order_relaxed);  // The running search is obsolete
+            }
+            wakeUp.notify_one();
+            return true;
+        }
+
+        /**
+         * Cancels the requested and running searches.
+         * A running search reports the result of its last completed iteration.
+         * @param env The JNI environment of the calling thread.
+         */
+        void cancel(JNIEnv *env) {
+            std::lock_guard<std::mutex> lock(mutex);
+            dropRequest(env);
+            cancelled.store(true, std::memory_order_relaxed);
+        }
+
+    private:
+        JavaVM *vm;
+        Connect4Solver solver;  // Only used by the worker thread, once the session is built
+        OpeningBook book;
+        std::atomic<bool> cancelled{false};  // Interrupts the running search
+
+        std::mutex mutex;  // Protects the members below
+        std::condition_variable wakeUp;  // Signaled when a search is requested or the session is closed
+        Position position;  // Current position of the game
+        int moves[Position::WIDTH * Position::HEIGHT];  // Moves of the game, the last one may be a winning move
+        int moveCount = 0;
+        bool gameOver = false;  // Whether the last move is a winning move
+        jobject request = nullptr;  // Global reference to the listener of the requested search, if any
+        Position requestPosition;
+        std::chrono::steady_clock::duration requestTimeLimit;
+        std::string loadPath;  // File of the requested loadCache(), empty if none
+        std::string savePath;  // File of the requested saveCache(), empty if none
+        bool busy = false;  // Whether the worker thread is searching or reading or writing a cache
+        bool stopping = false;
+
+        std::thread worker;  // Started last, once the other members are built
+
+        /**
+         * Forgets the requested search, must be called with the mutex held.
+         */
+        void dropRequest(JNIEnv *env) {
+            if (request) {
+                env->DeleteGlobalRef(request);
+                request = nullptr;
+            }
+        }
+
+        /**
+         * Calls the onAnalysis() method of a listener.
+         */
+        static void report(JNIEnv *env, jobject listener, jmethodID onAnalysis, const Connect4Solver::Analysis &analysis, bool done) {
+            jintArray columnScores = env->NewIntArray(Position::WIDTH);
+            env->SetIntArrayRegion(columnScores, 0, Position::WIDTH, analysis.columnScores);
+            jintArray principalVariation = env->NewIntArray(analysis.principalVariationLength);
+            env->SetIntArrayRegion(principalVariation, 0, analysis.principalVariationLength, analysis.principalVariation);
+            env->CallVoidMethod(listener, onAnalysis, analysis.depth, analysis.score, analysis.bestMove,
+                                static_cast<jboolean>(analysis.exact), columnScores, principalVariation, static_cast<jboolean>(done));
+            if (env->ExceptionCheck()) {
+                env->ExceptionClear();  // A failing listener must not bring the worker thread down
+            }
+            env->DeleteLocalRef(columnScores);
+            env->DeleteLocalRef(principalVariation);
+        }
+
+        /**
+         * Main loop of the worker thread, running the requested searches one after the other.
+         */
+        void run() {
+            JNIEnv *env;
+            vm->AttachCurrentThread(&env, nullptr);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;) {
+                wakeUp.wait(lock, [this] { return stopping || request || !loadPath.empty() || !savePath.empty(); });
+                if (!savePath.empty() || (!loadPath.empty() && !stopping)) {
+                    std::string load, save;
+                    load.swap(loadPath);
+                    save.swap(savePath);
+                    if (stopping) {
+                        load.clear();  // Only the results of the closing session matter
+                    }
+                    busy = true;
+                    lock.unlock();
+
+                    // Caches of several megabytes would stall the main thread of the app, which requested them
+                    if (!load.empty()) {
+                        solver.loadCache(load.c_str());
+                    }
+                    if (!save.empty()) {
+                        solver.saveCache(save.c_str());
+                    }
+
+                    lock.lock();
+                    busy = false;
+                    continue;
+                }
+                if (stopping) {
+                    break;
+                }
+                jobject listener = request;
+                request = nullptr;
+                Position searchPosition = requestPosition;
+                solver.setTimeLimit(requestTimeLimit);
+                cancelled.store(false, std::memory_order_relaxed);  // Cancellations from now on target this search
+                busy = true;
+                lock.unlock();
+
+                jclass listenerClass = env->GetObjectClass(listener);
+                jmethodID onAnalysis = env->GetMethodID(listenerClass, "onAnalysis", "(IIIZ[I[IZ)V");
+                env->DeleteLocalRef(listenerClass);
+                solver.setProgressCallback([env, listener, onAnalysis](const Connect4Solver::Analysis &analysis) {
+                    report(env, listener, onAnalysis, analysis, false);
+                });
+                Connect4Solver::Analysis analysis = solver.analyze(searchPosition);
+                solver.setProgressCallback(nullptr);
+                report(env, listener, onAnalysis, analysis, true);
+                env->DeleteGlobalRef(listener);
+
+                lock.lock();
+                busy = false;
+            }
+            lock.unlock();
+
+            vm->DetachCurrentThread();
+        }
+    };
+
+    Session *session(jlong handle) {
+        return reinterpret_cast<Session*>(handle);
+    }
+
+} // namespace
+
+extern "C" {
+
+JNIEXPORT jlong JNICALL
+Java_com_example_connect4_Connect4Engine_nativeCreate(JNIEnv *env, jobject) {
+    JavaVM *vm;
+    if (env->GetJavaVM(&vm) != JNI_OK) {
+        return 0;
+    }
+    return reinterpret_cast<jlong>(new Session(vm));
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_connect4_Connect4Engine_nativeDestroy(JNIEnv *env, jobject, jlong handle) {
+    session(handle)->close(env);
+    delete session(handle);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_connect4_Connect4Engine_nativePlay(JNIEnv *, jobject, jlong handle, jint column) {
+    return static_cast<jboolean>(session(handle)->play(column));
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_connect4_Connect4Engine_nativeUndo(JNIEnv *, jobject, jlong handle) {
+    return static_cast<jboolean>(session(handle)->undo());
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_connect4_Connect4Engine_nativeNewGame(JNIEnv *, jobject, jlong handle) {
+    session(handle)->newGame();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_example_connect4_Connect4Engine_nativeGetMoveCount(JNIEnv *, jobject, jlong handle) {
+    return session(handle)->getMoveCount();
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_connect4_Connect4Engine_nativeIsWinningMove(JNIEnv *, jobject, jlong handle, jint column) {
+    return static_cast<jboolean>(session(handle)->isWinningMove(column));
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_connect4_Connect4Engine_nativeOpenBook(JNIEnv *, jobject, jlong handle, jint fd, jlong offset, jlong length) {
+    return static_cast<jboolean>(session(handle)->openBook(fd, offset, length));
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_connect4_Connect4Engine_nativeLoadCache(JNIEnv *env, jobject, jlong handle, jstring path) {
+    const char *chars = env->GetStringUTFChars(path, nullptr);
+    session(handle)->loadCache(chars);
+    env->ReleaseStringUTFChars(path, chars);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_connect4_Connect4Engine_nativeSaveCache(JNIEnv *env, jobject, jlong handle, jstring path) {
+    const char *chars = env->GetStringUTFChars(path, nullptr);
+    session(handle)->saveCache(chars);
+    env->ReleaseStringUTFChars(path, chars);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_connect4_Connect4Engine_nativeAnalyze(JNIEnv *env, jobject, jlong handle, jlong timeLimitMillis, jobject listener) {
+    return static_cast<jboolean>(session(handle)->analyze(env, listener, timeLimitMillis));
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_connect4_Connect4Engine_nativeCancel(JNIEnv *env, jobject, jlong handle) {
+    session(handle)->cancel(env);
+}
+
+} // extern "C"
@@ -0,0 +1,124 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace GameSolver { namespace Connect4 {
+
+        /**
+         * A read-only memory mapping of a file or of a part of a file.
+         *
+         * Pages are loaded on demand and shared with the other processes mapping the same file,
+         * so a large table costs no memory until it is read. The mapping stays valid after the
+         * file descriptor is closed, until close() or the destruction of the object.
+         *
+         * A part of a file, such as an asset of an APK, only starts on the boundary its container
+         * aligns it to, so the values of the mapping are read with read() rather than through pointers.
+         */
+        class MappedFile {
+        public:
+            /**
+             * Maps a whole file.
+             * @param path: path of the file.
+             * @return true if the file was successfully mapped.
+             */
+            bool open(const char *path)
+            {
+                int fd = ::open(path, O_RDONLY);
+                if(fd < 0) return false;
+                struct stat st;
+                bool ok = fstat(fd, &st) == 0 && open(fd, 0, st.st_size);
+                ::close(fd); // the mapping stays valid after closing the descriptor
+                return ok;
+            }
+
+            /**
+             * Maps a part of a file, such as an uncompressed Android asset.
+             * The descriptor can be closed as soon as this function returns.
+             * @param fd: file descriptor open for reading.
+             * @param offset: offset of the part in the file.
+             * @param length: length of the part in bytes.
+             * @return true if the part was successfully mapped.
+             */
+            bool open(int fd, off_t offset, size_t length)
+            {
+                close();
+                if(length == 0) return false;
+
+                // mappings must start on a page boundary
+                off_t pageOffset = offset % sysconf(_SC_PAGE_SIZE);
+                void *m = mmap(nullptr, length + pageOffset, PROT_READ, MAP_SHARED, fd, offset - pageOffset);
+                if(m == MAP_FAILED) return false;
+                mapping = m;
+                mappingLength = length + pageOffset;
+                start = static_cast<const char*>(m) + pageOffset;
+                partLength = length;
+                return true;
+            }
+
+            /**
+             * Unmaps the file.
+             */
+            void close()
+            {
+                if(mapping) munmap(mapping, mappingLength);
+                mapping = nullptr;
+                mappingLength = 0;
+                start = nullptr;
+                partLength = 0;
+            }
+
+            /**
+             * @return the first byte of the mapped part, nullptr if nothing is mapped.
+             */
+            const char *data() const
+            {
+                return start;
+            }
+
+            /**
+             * Reads a value of the mapped part, whatever its alignment.
+             * @param offset: offset of the value in the mapped part, in bytes.
+             * @return a copy of the value.
+             */
+            template<class T>
+            T read(size_t offset) const
+            {
+                T value;
+                std::memcpy(&value, start + offset, sizeof(T));
+                return value;
+            }
+
+            /**
+             * @return the length of the mapped part in bytes.
+             */
+            size_t size() const
+            {
+                return partLength;
+            }
+
+            MappedFile() : mapping{nullptr}, mappingLength{0}, start{nullptr}, partLength{0} {}
+
+            ~MappedFile()
+            {
+                close();
+            }
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+        private:
+            void *mapping;         // memory mapping, starting on a page boundary
+            size_t mappingLength;  // length of the mapping
+            const char *start;     // first byte of the mapped part, inside the mapping
+            size_t partLength;     // length of the mapped part
+        };
+
+    }} // end namespaces
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef MOVE_SORTER_HPP
+#define MOVE_SORTER_HPP
+
+#include "board.hpp"
+
+namespace GameSolver { namespace Connect4 {
+
+        /**
+         * This class helps sorting the next moves.
+         *
+         * Moves are added one by one with a score and are retrieved from the highest
+         * to the lowest score. Moves with the same score are retrieved from the last
+         * added to the first added, so adding moves from the least to the most promising
+         * column gives a static tie-break order.
+         *
+         * The sorter never holds more than Width moves and does not allocate: an insertion
+         * sort over at most Width entries is cheaper than any heap based structure.
+         *
+         * @tparam Width width of the board, the maximum number of moves.
+         */
+        template<int Width>
+        class BasicMoveSorter {
+        public:
+            /**
+             * Adds a move to the container with its score.
+             * You cannot add more than Width moves.
+             * @param move: 0-based index of the column to play.
+             * @param score: score of the move, higher scores are retrieved first.
+             */
+            void add(int move, int score)
+            {
+                int pos = size++;
+                for(; pos && entries[pos - 1].score > score; --pos) entries[pos] = entries[pos - 1];
+                entries[pos].move = move;
+                entries[pos].score = score;
+            }
+
+            /**
+             * Gets the next move and removes it from the container.
+             * @return the best remaining move, or -1 if there is no more move.
+             */
+            int getNext()
+            {
+                if(size) return entries[--size].move;
+                return -1;
+            }
+
+            /**
+             * Removes all moves from the container.
+             */
+            void reset()
+            {
+                size = 0;
+            }
+
+            /**
+             * Default constructor, build an empty container.
+             */
+            BasicMoveSorter() : size{0} {}
+
+        private:
+            unsigned int size;  // number of stored moves
+
+            // moves sorted by increasing score
+            struct {
+                int move;
+                int score;
+            } entries[Width];
+        };
+
+        typedef BasicMoveSorter<Position::WIDTH> MoveSorter;  // Sorter of the moves of the standard board
+
+    }} // end namespaces
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef OPENING_BOOK_HPP
+#define OPENING_BOOK_HPP
+
+#include "board.hpp"
+#include "mapped_file.hpp"
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+namespace GameSolver { namespace Connect4 {
+
+        /**
+         * A read-only table of exact scores for early positions.
+         *
+         * A book file is made of a header followed by entries sorted by key:
+         * - header: "C4BK" magic, format version, board width and height, number of plies covered
+         *   and number of entries
+         * - entries: 64 bits records holding a canonical position key on the low 56 bits and
+         *   the score as a signed byte on the high 8 bits
+         *
+         * Positions are stored under Position::canonicalKey() so that a position and its mirror
+         * share an entry. Files use the native byte order.
+         *
+         * Books are memory-mapped read-only: opening a book neither reads nor parses it and lookups
+         * are binary searches directly in the mapping, which the OS shares between processes.
+         * On Android the book is shipped as an uncompressed asset and opened from the file
+         * descriptor, offset and length returned by AAsset_openFileDescriptor64().
+         */
+        class OpeningBook {
+        public:
+            static const uint32_t VERSION = 1;
+
+            struct Header {
+                char magic[4];      // "C4BK"
+                uint32_t version;   // VERSION
+                uint32_t width;     // Position::WIDTH of the book's positions
+                uint32_t height;    // Position::HEIGHT of the book's positions
+                uint32_t maxPlies;  // every position with at most maxPlies moves is in the book
+                uint32_t reserved;
+                uint64_t size;      // number of entries following the header
+            };
+
+            /**
+             * Packs a book entry.
+             * @param key: canonical key of the position.
+             * @param score: exact score of the position.
+             */
+            static uint64_t packEntry(uint64_t key, int score)
+            {
+                return key | static_cast<uint64_t>(static_cast<uint8_t>(static_cast<int8_t>(score))) << 56;
+            }
+
+            /**
+             * Writes a book file.
+             * @param path: path of the file to create.
+             * @param entries: entries built with packEntry(), sorted in place by this function.
+             * @param maxPlies: number of plies covered by the book.
+             * @return true if the file was successfully written.
+             */
+            static bool write(const char *path, std::vector<uint64_t> &entries, unsigned int maxPlies)
+            {
+                std::sort(entries.begin(), entries.end(), [](uint64_t a, uint64_t b) { return entryKey(a) < entryKey(b); });
+
+                Header header;
+                std::memcpy(header.magic, "C4BK", 4);
+                header.version = VERSION;
+                header.width = Position::WIDTH;
+                header.height = Position::HEIGHT;
+                header.maxPlies = maxPlies;
+                header.reserved = 0;
+                header.size = entries.size();
+
+                FILE *file = std::fopen(path, "wb");
+                if(!file) return false;
+                bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                          std::fwrite(entries.data(), sizeof(uint64_t), entries.size(), file) == entries.size();
+                return std::fclose(file) == 0 && ok;
+            }
+
+            /**
+             * Opens a book file.
+             * @param path: path of the book file.
+             * @return true if the book was successfully opened.
+             */
+            bool open(const char *path)
+            {
+                close();
+                return file.open(path) && validate();
+            }
+
+            /**
+             * Opens a book stored in a part of a file, such as an uncompressed Android asset.
+             * The descriptor can be closed as soon as this function returns.
+             * @param fd: file descriptor open for reading.
+             * @param offset: offset of the book in the file.
+             * @param length: length of the book in bytes.
+             * @return true if the book was successfully opened.
+             */
+            bool open(int fd, off_t offset, size_t length)
+            {
+                close();
+                return file.open(fd, offset, length) && validate();
+            }
+
+            /**
+             * Closes the book, it then contains no position.
+             */
+            void close()
+            {
+                file.close();
+                opened = false;
+            }
+
+            /**
+             * @return true if a book is open.
+             */
+            bool isOpen() const
+            {
+                return opened;
+            }
+
+            /**
+             * @return the number of plies covered by the book, 0 if no book is open.
+             */
+            unsigned int getMaxPlies() const
+            {
+                return opened ? header.maxPlies : 0;
+            }
+
+            /**
+             * @return the number of positions of the book.
+             */
+            size_t size() const
+            {
+                return opened ? header.size : 0;
+            }
+
+            /**
+             * Looks up the score of a position.
+             * @param position: the position to look up.
+             * @param score: set to the exact score of the position if it is in the book.
+             * @return true if the position is in the book.
+             */
+            bool get(const Position &position, int &score) const
+            {
+                if(!opened || position.nbMoves() > header.maxPlies) return false;
+                uint64_t key = position.canonicalKey();
+                size_t first = 0, count = header.size;
+                while(count > 0) {
+                    size_t half = count / 2;
+                    if(entryKey(entry(first + half)) < key) {
+                        first += half + 1;
+                        count -= half + 1;
+                    } else {
+                        count = half;
+                    }
+                }
+                if(first == header.size || entryKey(entry(first)) != key) return false;
+                score = static_cast<int8_t>(entry(first) >> 56);
+                return true;
+            }
+
+            /**
+             * Default constructor, build an empty book.
+             */
+            OpeningBook() : header(), opened{false} {}
+
+        private:
+            MappedFile file;  // memory mapping of the book file
+            Header header;    // copy of the header of the book
+            bool opened;      // whether a valid book is mapped
+
+            // return the entry of a given rank, the sorted entries follow the header in the mapping
+            uint64_t entry(size_t rank) const
+            {
+                return file.read<uint64_t>(sizeof(Header) + rank * sizeof(uint64_t));
+            }
+
+            static uint64_t entryKey(uint64_t entry)
+            {
+                return entry & ((UINT64_C(1) << 56) - 1);
+            }
+
+            /**
+             * Checks the header of the mapped file.
+             * @return true if the file is a book of the board, it is closed otherwise.
+             */
+            bool validate()
+            {
+                if(file.size() < sizeof(Header)) {
+                    close();
+                    return false;
+                }
+                Header h = file.read<Header>(0);
+                if(std::memcmp(h.magic, "C4BK", 4) != 0 || h.version != VERSION ||
+                   h.width != Position::WIDTH || h.height != Position::HEIGHT ||
+                   h.size > (file.size() - sizeof(Header)) / sizeof(uint64_t)) {
+                    close();
+                    return false;
+                }
+                header = h;
+                opened = true;
+                return true;
+            }
+        };
+
+    }} // end namespaces
+
+#endif
@@ -0,0 +1,98 @@
+#include "position_record.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace GameSolver::Connect4;
+
+/**
+ * Converts the lines "<move sequence> [score]" of position sets into records, other fields are dropped.
+ */
+template<class P>
+static int toBinary() {
+    LineReader input(STDIN_FILENO);
+    BufferedWriter output(STDOUT_FILENO);
+    PositionRecordWriter<P> writer(output);
+    const char *line;
+    size_t length;
+    for (size_t lineNumber = 1; input.next(line, length); lineNumber++) {
+        const char *end = line + length;
+        const char *space = static_cast<const char*>(std::memchr(line, ' ', length));
+        size_t movesLength = space ? space - line : length;
+        PositionRecord<P> record;
+        if (record.position.play(line, movesLength) != movesLength) {
+            std::cerr << "Line " << lineNumber << ": Invalid move " << (record.position.nbMoves() + 1) << "\n";
+            continue;
+        }
+        if (space) {
+            std::string field(space + 1, std::find(space + 1, end, ' '));
+            char *parsed;
+            long score = std::strtol(field.c_str(), &parsed, 10);
+            if (field.empty() || *parsed || score < P::MIN_SCORE || score > P::MAX_SCORE) {
+                std::cerr << "Line " << lineNumber << ": Invalid score \"" << field << "\"\n";
+                continue;
+            }
+            record.score = static_cast<int>(score);
+        }
+        writer.write(record);
+    }
+    output.flush();
+    return output.fail() ? 1 : 0;
+}
+
+/**
+ * Converts records into lines "<move sequence> [score]", whose move sequences replay the positions of the
+ * records but not necessarily the games they were taken from.
+ */
+template<class P>
+static int toText() {
+    PositionRecordReader<P> reader(STDIN_FILENO);
+    if (!reader.isValid()) {
+        std::cerr << "The input is not a position file of the board\n";
+        return 1;
+    }
+    BufferedWriter output(STDOUT_FILENO);
+    uint64_t packed;
+    std::string moves;
+    for (size_t recordNumber = 1; reader.next(packed); recordNumber++) {
+        PositionRecord<P> record;
+        if (!record.unpack(packed) || !record.position.moveSequence(moves)) {
+            std::cerr << "Record " << recordNumber << ": Invalid position\n";
+            continue;
+        }
+        output.write(moves.data(), moves.size());
+        if (record.score != PositionRecord<P>::NO_SCORE) {
+            output.write(' ').write(record.score);
+        }
+        output.write('\n');
+    }
+    output.flush();
+    return output.fail() ? 1 : 0;
+}
+
+/**
+ * Converts position sets between their text format, as read by the command line solver and the benchmark,
+ * and position files of 8 bytes per position, see PositionRecord.
+ */
+int main(int argc, char **argv) {
+    std::string direction = argc > 1 ? argv[1] : "";
+    std::string board = "7x6";
+    bool hasBoard = argc == 4 && std::string(argv[2]) == "--board";
+    if (hasBoard) {
+        board = argv[3];
+    }
+    if ((direction != "to-binary" && direction != "to-text") || (argc != 2 && !hasBoard)) {
+        std::cerr << "Usage: " << argv[0] << " to-binary|to-text [--board 7x6|6x5] < <input> > <output>\n";
+        return 1;
+    }
+
+    bool binary = direction == "to-binary";
+    if (board == "7x6") {
+        return binary ? toBinary<Position>() : toText<Position>();
+    } else if (board == "6x5") {
+        return binary ? toBinary<BasicPosition<6, 5>>() : toText<BasicPosition<6, 5>>();
+    }
+    std::cerr << "Unsupported board \"" << board << "\"\n";
+    return 1;
+}
@@ -0,0 +1,167 @@
+#ifndef POSITION_RECORD_HPP
+#define POSITION_RECORD_HPP
+
+#include "board.hpp"
+#include "stream_io.hpp"
+#include <cstdint>
+#include <cstring>
+
+namespace GameSolver { namespace Connect4 {
+
+        /**
+         * A position and its optional score and best move, stored in 64 bits by position files.
+         *
+         * A record packs the fields of a position of the board in native byte order:
+         * - bits 0-48: key() of the position
+         * - bits 49-54: number of moves of the position, checked against the key
+         * - bits 55-60: score - MIN_SCORE + 1, 0 if the record has no score
+         * - bits 61-63: column of the best move + 1, 0 if the record has no best move
+         *
+         * Records are decoded with Position::setKey(), without replaying moves. Boards whose keys
+         * do not fit, such as 8x7, are not SUPPORTED.
+         *
+         * @tparam P the BasicPosition of the board geometry.
+         */
+        template<class P>
+        struct PositionRecord {
+            static constexpr bool SUPPORTED = P::KEY_BITS <= 49 && P::WIDTH <= 7 &&
+                                              P::WIDTH * P::HEIGHT < 64 && P::MAX_SCORE - P::MIN_SCORE + 1 < 64;
+            static const int NO_SCORE = -128;  // score of the records without a score
+
+            P position;
+            int score = NO_SCORE;
+            int bestMove = -1;  // 0-based column, -1 if the record has no best move
+
+            PositionRecord() = default;
+            PositionRecord(const P &position, int score = NO_SCORE, int bestMove = -1)
+                    : position(position), score(score), bestMove(bestMove) {}
+
+            /**
+             * Packs the record, scores outside of [MIN_SCORE, MAX_SCORE] and columns outside of the board
+             * are packed as missing so that they never spill into the other fields.
+             */
+            uint64_t pack() const
+            {
+                uint64_t record = static_cast<uint64_t>(position.key()) | static_cast<uint64_t>(position.nbMoves()) << 49;
+                if(score >= P::MIN_SCORE && score <= P::MAX_SCORE) record |= static_cast<uint64_t>(score - P::MIN_SCORE + 1) << 55;
+                if(bestMove >= 0 && bestMove < P::WIDTH) record |= static_cast<uint64_t>(bestMove + 1) << 61;
+                return record;
+            }
+
+            /**
+             * @return true if the record holds a position without alignment and valid fields.
+             */
+            bool unpack(uint64_t record)
+            {
+                P p;
+                if(!p.setKey(static_cast<typename P::bitboard_t>(record & ((UINT64_C(1) << 49) - 1))) ||
+                   p.nbMoves() != (record >> 49 & 63)) {
+                    return false;
+                }
+                int s = static_cast<int>(record >> 55 & 63);
+                int m = static_cast<int>(record >> 61);
+                if((s && s - 1 + P::MIN_SCORE > P::MAX_SCORE) || m > P::WIDTH) return false;
+                position = p;
+                score = s ? s - 1 + P::MIN_SCORE : NO_SCORE;
+                bestMove = m - 1;
+                return true;
+            }
+        };
+
+        template<class P> constexpr bool PositionRecord<P>::SUPPORTED;
+        template<class P> const int PositionRecord<P>::NO_SCORE;
+
+        /**
+         * Header of position files, followed by their records.
+         */
+        struct PositionFileHeader {
+            static const uint32_t VERSION = 1;
+
+            char magic[4];    // "C4PR"
+            uint32_t version; // VERSION
+            uint32_t width;   // Position::WIDTH of the records
+            uint32_t height;  // Position::HEIGHT of the records
+
+            template<class P>
+            static PositionFileHeader of()
+            {
+                PositionFileHeader header;
+                std::memcpy(header.magic, "C4PR", 4);
+                header.version = VERSION;
+                header.width = P::WIDTH;
+                header.height = P::HEIGHT;
+                return header;
+            }
+        };
+
+        /**
+         * Reads the records of a position file from a file descriptor, memory-mapped for regular files
+         * and streamed otherwise, see InputStream.
+         */
+        template<class P>
+        class PositionRecordReader {
+        public:
+            explicit PositionRecordReader(int fd, void (*beforeRead)(void*) = nullptr, void *arg = nullptr)
+                    : input{fd, beforeRead, arg}, valid{false}
+            {
+                while(input.size() < sizeof(PositionFileHeader) && input.fill()) {}
+                if(input.size() < sizeof(PositionFileHeader)) return;
+                PositionFileHeader header, expected = PositionFileHeader::of<P>();
+                std::memcpy(&header, input.data(), sizeof(header));
+                valid = std::memcmp(&header, &expected, sizeof(header)) == 0;
+                input.consume(sizeof(header));
+            }
+
+            /**
+             * @return true if the input starts with the header of a position file of the board.
+             */
+            bool isValid() const
+            {
+                return valid;
+            }
+
+            /**
+             * Gets the next record, without checking it.
+             * @return false once the input is exhausted, cannot be read or is not a position file of the board.
+             */
+            bool next(uint64_t &record)
+            {
+                if(!valid) return false;
+                while(input.size() < sizeof(record)) {
+                    if(!input.fill()) return false;  // a truncated last record is ignored
+                }
+                std::memcpy(&record, input.data(), sizeof(record));
+                input.consume(sizeof(record));
+                return true;
+            }
+
+        private:
+            InputStream input;
+            bool valid;
+        };
+
+        /**
+         * Writes a position file through a BufferedWriter, starting with its header.
+         */
+        template<class P>
+        class PositionRecordWriter {
+        public:
+            explicit PositionRecordWriter(BufferedWriter &output) : output(output)
+            {
+                PositionFileHeader header = PositionFileHeader::of<P>();
+                output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            }
+
+            void write(const PositionRecord<P> &record)
+            {
+                uint64_t packed = record.pack();
+                output.write(reinterpret_cast<const char*>(&packed), sizeof(packed));
+            }
+
+        private:
+            BufferedWriter &output;
+        };
+
+    }} // end namespaces
+
+#endif
@@ -0,0 +1,372 @@
+#ifndef SESSION_MANAGER_HPP
+#define SESSION_MANAGER_HPP
+
+#include "solver.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace GameSolver {
+    namespace Connect4 {
+
+        /**
+        * Serves the analyses of many concurrent games, e.g. for a game server, with a fixed pool of worker threads
+        * whose solvers share one TranspositionTable: the memory of the manager does not grow with the number of
+        * games, and the positions of every game reuse the results of the others.
+        *
+        * Requests are served by priority, INTERACTIVE requests before BACKGROUND ones, then by deadline. The time
+        * limit of each request runs from the request, so the time spent waiting for a worker is part of it. An
+        * INTERACTIVE request finding no idle worker cancels a BACKGROUND search, which then reports the result of
+        * its last completed iteration as if its time had expired.
+        *
+        * The methods may be called from any thread. Callbacks are called on the worker threads, without any lock
+        * held, so they may make new requests.
+        * @tparam P The BasicPosition of the board geometry of the games.
+        */
+        template<class P>
+        class BasicSessionManager {
+        public:
+            typedef BasicSolver<P> Solver;
+            typedef typename Solver::Position Position;
+            typedef typename Solver::Analysis Analysis;
+            typedef typename Solver::CacheStats CacheStats;
+            typedef unsigned long long GameId;  // Identifier of a game, never reused by a manager
+
+            /**
+            * Scheduling class of an analysis request.
+            */
+            enum Priority {
+                INTERACTIVE,  // Moves a player is waiting for, served first
+                BACKGROUND    // Analyses nobody waits for, e.g. hints computed ahead or reviews of finished games
+            };
+
+            /**
+            * Receives the result of an analysis on a worker thread, it must not throw.
+            */
+            typedef std::function<void(GameId game, const Analysis &analysis)> Callback;
+
+            /**
+             * Starts the worker threads.
+             * @param workerCount The number of worker threads, at least 1.
+             * @param memoryLimit The bytes of memory of the TranspositionTable shared by the workers.
+             * @param depthLimit The depth limit of the analyses.
+             * @throw std::bad_alloc if the memory cannot be reserved.
+             */
+            explicit BasicSessionManager(unsigned int workerCount, size_t memoryLimit = Solver::DEFAULT_MEMORY_LIMIT,
+                                         int depthLimit = std::numeric_limits<int>::max())
+                    : cache(memoryLimit) {
+                workerCount = std::max(workerCount, 1u);
+                for (unsigned int i = 0; i < workerCount; i++) {
+                    workers.emplace_back(new Worker(cache, depthLimit));
+                }
+                for (std::unique_ptr<Worker> &worker : workers) {
+                    worker->thread = std::thread(&BasicSessionManager::run, this, std::ref(*worker));
+                }
+            }
+
+            /**
+             * Drops the queued requests, cancels the running searches and stops the worker threads.
+             * The callbacks of the cancelled searches are still called.
+             */
+            ~BasicSessionManager() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopping = true;
+                    requests.clear();
+                    for (std::unique_ptr<Worker> &worker : workers) {
+                        worker->cancelled.store(true, std::memory_order_relaxed);
+                    }
+                }
+                wakeUp.notify_all();
+                for (std::unique_ptr<Worker> &worker : workers) {
+                    worker->thread.join();
+                }
+            }
+
+            BasicSessionManager(const BasicSessionManager&) = delete;
+            BasicSessionManager& operator=(const BasicSessionManager&) = delete;
+
+            /**
+             * Starts a game from the empty board.
+             * @return The identifier of the game.
+             */
+            GameId openGame() {
+                std::lock_guard<std::mutex> lock(mutex);
+                GameId game = nextGame++;
+                games[game] = Game();
+                return game;
+            }
+
+            /**
+             * Forgets a game and drops its queued requests. Its running search, if any, completes and reports its result.
+             */
+            void closeGame(GameId game) {
+                std::lock_guard<std::mutex> lock(mutex);
+                games.erase(game);
+                size_t queued = requests.size();
+                requests.erase(std::remove_if(requests.begin(), requests.end(),
+                                              [game](const Request &request) { return request.game == game; }),
+                               requests.end());
+                std::make_heap(requests.begin(), requests.end(), Later());
+                pending -= queued - requests.size();
+                if (pending == 0) {
+                    idle.notify_all();
+                }
+            }
+
+            /**
+             * Plays a move of a game.
+             * A winning move ends the game: no other move can be played and the game cannot be analyzed.
+             * @param column The column of the move, from 0 for the leftmost one.
+             * @return false if the game is unknown or over, or the move cannot be played.
+             */
+            bool play(GameId game, int column) {
+                std::lock_guard<std::mutex> lock(mutex);
+                typename std::unordered_map<GameId, Game>::iterator it = games.find(game);
+                if (it == games.end()) {
+                    return false;
+                }
+                Game &state = it->second;
+                if (state.gameOver || column < 0 || column >= Position::WIDTH || !state.position.canPlay(column)) {
+                    return false;
+                }
+                if (state.position.isWinningMove(column)) {
+                    state.gameOver = true;  // Position does not hold alignments
+                } else {
+                    state.position.play(column);
+                }
+                return true;
+            }
+
+            /**
+             * Requests the analysis of the current position of a game, see BasicSolver::analyze().
+             * Moves played meanwhile do not change the position analyzed.
+             * @param priority The scheduling class of the request.
+             * @param timeLimit The time limit of the analysis, counted from now.
+             * @param callback The function receiving the result of the last completed iteration of the analysis.
+             * @return false if the game is unknown or over.
+             */
+            bool analyze(GameId game, Priority priority, std::chrono::steady_clock::duration timeLimit, Callback callback) {
+                std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    typename std::unordered_map<GameId, Game>::const_iterator it = games.find(game);
+                    if (it == games.end() || it->second.gameOver) {
+                        return false;
+                    }
+
+                    Request request;
+                    request.game = game;
+                    request.priority = priority;
+                    // Time limits such as duration::max() would overflow the clock
+                    request.deadline = timeLimit < std::chrono::steady_clock::time_point::max() - now ?
+                                       now + timeLimit : std::chrono::steady_clock::time_point::max();
+                    request.sequence = nextSequence++;
+                    request.position = it->second.position;
+                    request.callback = std::move(callback);
+                    requests.push_back(std::move(request));
+                    std::push_heap(requests.begin(), requests.end(), Later());
+                    pending++;
+
+                    if (priority == INTERACTIVE) {
+                        preemptBackground();
+                    }
+                }
+                wakeUp.notify_one();
+                return true;
+            }
+
+            /**
+             * Sets the opening book consulted by the analyses, see BasicSolver::setOpeningBook().
+             * Running analyses keep the previous book, which must outlive them.
+             */
+            void setOpeningBook(const OpeningBook *book) {
+                std::lock_guard<std::mutex> lock(mutex);
+                openingBook = book;
+            }
+
+            /**
+             * Sets the endgame table probed by the analyses, see BasicSolver::setEndgameTable().
+             * Running analyses keep the previous table, which must outlive them.
+             */
+            void setEndgameTable(const EndgameTable *table) {
+                std::lock_guard<std::mutex> lock(mutex);
+                endgameTable = table;
+            }
+
+            /**
+             * Waits until every request is served or dropped.
+             */
+            void wait() {
+                std::unique_lock<std::mutex> lock(mutex);
+                idle.wait(lock, [this] { return pending == 0; });
+            }
+
+            size_t getGameCount() const {
+                std::lock_guard<std::mutex> lock(mutex);
+                return games.size();
+            }
+
+            /**
+             * @return The number of requests waiting for a worker.
+             */
+            size_t getQueueLength() const {
+                std::lock_guard<std::mutex> lock(mutex);
+                return requests.size();
+            }
+
+            size_t getWorkerCount() const {
+                return workers.size();
+            }
+
+            /**
+             * @return The usage of the shared TranspositionTable, see BasicSolver::getCacheStats().
+             */
+            CacheStats getCacheStats() const {
+                return cache.getStats();
+            }
+
+            /**
+             * @return The bytes of memory of the shared TranspositionTable, whatever the number of games.
+             */
+            size_t getMemoryUsage() const {
+                return cache.getMemoryUsage();
+            }
+
+        private:
+            /**
+            * State of a game.
+            */
+            struct Game {
+                Position position;  // Current position of the game
+                bool gameOver = false;  // Whether the last move is a winning move
+            };
+
+            /**
+            * Analysis of a position of a game, waiting for a worker.
+            */
+            struct Request {
+                GameId game;
+                Priority priority;
+                std::chrono::steady_clock::time_point deadline;  // End of the time limit of the analysis
+                unsigned long long sequence;  // Order of the requests, to serve requests of the same deadline in order
+                Position position;  // Position of the game when the analysis was requested
+                Callback callback;
+            };
+
+            /**
+            * Orders the heap of the requests, the first request served is the greatest.
+            */
+            struct Later {
+                bool operator()(const Request &a, const Request &b) const {
+                    if (a.priority != b.priority) {
+                        return a.priority > b.priority;
+                    }
+                    if (a.deadline != b.deadline) {
+                        return a.deadline > b.deadline;
+                    }
+                    return a.sequence > b.sequence;
+                }
+            };
+
+            /**
+            * Worker thread and its solver, sharing the cache of the manager.
+            */
+            struct Worker {
+                Solver solver;  // Only used by the worker thread
+                std::atomic<bool> cancelled{false};  // Interrupts the running search
+                bool busy = false;  // Whether the worker is searching, protected by the mutex of the manager
+                Priority priority = BACKGROUND;  // Priority of the running search, if any
+                std::thread thread;
+
+                Worker(typename Solver::Cache &cache, int depthLimit)
+                        : solver(cache, std::chrono::steady_clock::duration::max(), depthLimit) {
+                    solver.setCancelFlag(&cancelled);
+                }
+            };
+
+            typename Solver::Cache cache;  // TranspositionTable shared by the solvers of the workers
+            std::vector<std::unique_ptr<Worker>> workers;
+
+            mutable std::mutex mutex;  // Protects the members below and the state of the workers
+            std::condition_variable wakeUp;  // Signaled when a request is queued or the manager stops
+            std::condition_variable idle;  // Signaled when the last pending request is served or dropped
+            std::unordered_map<GameId, Game> games;
+            std::vector<Request> requests;  // Heap of the queued requests, ordered by Later
+            size_t pending = 0;  // Number of requests queued or running
+            GameId nextGame = 1;
+            unsigned long long nextSequence = 0;
+            const OpeningBook *openingBook = nullptr;
+            const EndgameTable *endgameTable = nullptr;
+            bool stopping = false;
+
+            /**
+             * Cancels a BACKGROUND search when the queued INTERACTIVE requests outnumber the idle workers,
+             * must be called with the mutex held.
+             */
+            void preemptBackground() {
+                size_t interactive = std::count_if(requests.begin(), requests.end(),
+                                                   [](const Request &request) { return request.priority == INTERACTIVE; });
+                size_t idleWorkers = std::count_if(workers.begin(), workers.end(),
+                                                   [](const std::unique_ptr<Worker> &worker) { return !worker->busy; });
+                if (interactive <= idleWorkers) {
+                    return;
+                }
+                for (std::unique_ptr<Worker> &worker : workers) {
+                    if (worker->busy && worker->priority == BACKGROUND && !worker->cancelled.load(std::memory_order_relaxed)) {
+                        worker->cancelled.store(true, std::memory_order_relaxed);
+                        return;
+                    }
+                }
+            }
+
+            /**
+             * Main loop of a worker thread.
+             */
+            void run(Worker &worker) {
+                for (;;) {
+                    Request request;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        wakeUp.wait(lock, [this] { return stopping || !requests.empty(); });
+                        if (stopping) {
+                            return;
+                        }
+                        std::pop_heap(requests.begin(), requests.end(), Later());
+                        request = std::move(requests.back());
+                        requests.pop_back();
+                        worker.busy = true;
+                        worker.priority = request.priority;
+                        worker.cancelled.store(false, std::memory_order_relaxed);
+                        worker.solver.setOpeningBook(openingBook);
+                        worker.solver.setEndgameTable(endgameTable);
+                    }
+
+                    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                    worker.solver.setTimeLimit(request.deadline > now ? request.deadline - now : std::chrono::steady_clock::duration::zero());
+                    Analysis analysis = worker.solver.analyze(request.position);
+                    request.callback(request.game, analysis);
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    worker.busy = false;
+                    if (--pending == 0) {
+                        idle.notify_all();
+                    }
+                }
+            }
+        };
+
+        typedef BasicSessionManager<Position> SessionManager;  // Session manager of the standard board
+
+    } // namespace Connect4
+} // namespace GameSolver
+
+#endif
@@ -0,0 +1,583 @@
+#include "solver.hpp"
+#include "move_sorter.hpp"
+#include "opening_book.hpp"
+#include "endgame_table.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace GameSolver::Connect4;
+
+namespace {
+
+    /**
+     * Looks up a position in the opening book, books only hold positions of the standard board.
+     */
+    template<class P>
+    bool lookUpBook(const OpeningBook *, const P &, int &) {
+        return false;
+    }
+
+    bool lookUpBook(const OpeningBook *book, const Position &position, int &score) {
+        return book && book->get(position, score);
+    }
+
+    /**
+     * Looks up a position in the endgame table, tables only hold positions of the standard board.
+     */
+    template<class P>
+    bool lookUpEndgame(const EndgameTable *, const P &, int &) {
+        return false;
+    }
+
+    bool lookUpEndgame(const EndgameTable *table, const Position &position, int &score) {
+        return table && table->get(position, score);
+    }
+
+    /**
+     * Adds the time spent in its scope to a phase of SearchStats, compiled away unless SEARCH_TIMERS is set.
+     */
+    class PhaseTimer {
+    public:
+        explicit PhaseTimer(std::chrono::steady_clock::duration &total) noexcept : total(total) {
+            if (SEARCH_TIMERS) start = std::chrono::steady_clock::now();
+        }
+
+        ~PhaseTimer() {
+            if (SEARCH_TIMERS) total += std::chrono::steady_clock::now() - start;
+        }
+
+    private:
+        std::chrono::steady_clock::duration &total;
+        std::chrono::steady_clock::time_point start;
+    };
+
+} // namespace
+
+template<class P>
+const int BasicSolver<P>::INVALID_SCORE;
+template<class P>
+const int BasicSolver<P>::FULL_DEPTH;
+template<class P>
+const uint32_t BasicSolver<P>::CACHE_FORMAT;
+template<class P>
+constexpr size_t BasicSolver<P>::DEFAULT_MEMORY_LIMIT;
+template<class P>
+constexpr bool BasicSolver<P>::SearchStats::COUNTED;
+template<class P>
+constexpr bool BasicSolver<P>::SearchStats::TIMED;
+template<class P>
+const int BasicSolver<P>::SearchStats::MAX_ITERATIONS;
+
+template<class P>
+int BasicSolver<P>::negamax(Position &currentPosition, int depth, int alpha, int beta, SearchContext &context) noexcept {
+    if (context.aborted()) {
+        return 0; // Meaningless, the callers unwind without using it
+    }
+    // Reading the clock costs more than searching a node on phones, so the time limit is only polled,
+    // together with the cancellation flag
+    if ((++context.nodeCount & (TIME_CHECK_INTERVAL - 1)) == 0 &&
+        ((cancelFlag && cancelFlag->load(std::memory_order_relaxed)) ||
+         std::chrono::steady_clock::now() - context.startTime >= timeLimit)) {
+        context.interrupted = true;
+        return 0;
+    }
+    int nbMoves = currentPosition.nbMoves();
+
+    if (nbMoves >= Position::WIDTH * Position::HEIGHT) {
+        return 0; // Draw game
+    }
+
+    if (currentPosition.canWinNext()) {
+        return (Position::WIDTH * Position::HEIGHT + 1 - nbMoves) / 2; // Win with the next move
+    }
+
+    typename Position::bitboard_t next;
+    {
+        PhaseTimer timer(context.stats.moveOrderingTime);
+        next = currentPosition.possibleNonLosingMoves();
+    }
+    if (next == 0) {
+        return -(Position::WIDTH * Position::HEIGHT - nbMoves) / 2; // Every move lets the opponent win
+    }
+
+    // Searching past the last move does not change the score, so entries of full depth searches are valid at any depth
+    depth = std::min(depth, Position::WIDTH * Position::HEIGHT - nbMoves);
+
+    // Positions of the endgame table end the search with their exact score, including at the depth limit
+    int endgameScore;
+    if (lookUpEndgame(endgameTable, currentPosition, endgameScore)) {
+        return endgameScore;
+    }
+
+    if (depth == 0) {
+        context.estimateCount++;
+        PhaseTimer timer(context.stats.evaluationTime);
+        return currentPosition.evaluate(); // Unknown outcome, estimated without searching
+    }
+
+    // A search that uses no estimate finds the same result as a search to the end of the game
+    unsigned long long estimatesBefore = context.estimateCount;
+
+    // Use the bounds stored in the TranspositionTable if they come from a deep enough search,
+    // and the best move of any search to order the moves
+    typename TransTable::value_t ttEntry;
+    {
+        PhaseTimer timer(context.stats.transTableTime);
+        ttEntry = context.transTable.get(tableKey(currentPosition));
+    }
+    if (SEARCH_STATS) {
+        context.stats.ttProbes++;
+        context.stats.ttHits += ttEntry != 0;
+    }
+    int ttMove = ttEntry != 0 ? entryMove(ttEntry) : -1;
+    if (ttEntry != 0 && entryDepth(ttEntry) >= depth) {
+        if (entryDepth(ttEntry) < Position::WIDTH * Position::HEIGHT) {
+            context.estimateCount++;  // Bounds of a depth limited search
+        }
+        int ttScore = entryScore(ttEntry);
+        switch (entryBound(ttEntry)) {
+            case EXACT_SCORE: alpha = beta = ttScore; break;
+            case LOWER_BOUND: alpha = std::max(alpha, ttScore); break;
+            case UPPER_BOUND: beta = std::min(beta, ttScore); break;
+        }
+        if (alpha >= beta) {
+            if (SEARCH_STATS) context.stats.ttCutoffs++;
+            return ttScore;
+        }
+    }
+
+    // We cannot win with the next move, so the score is at most the one of a win with our following move.
+    // Early in the game, both bounds are beyond the scores of the board, which the TranspositionTable is sized for
+    int max = std::min((Position::WIDTH * Position::HEIGHT - 1 - nbMoves) / 2, Position::MAX_SCORE);
+    if (beta > max) {
+        beta = max;
+        if (alpha >= beta) {
+            return beta;
+        }
+    }
+
+    // The opponent cannot win with their next move, so the score is at least the one of a loss with their following move
+    int min = std::max(-(Position::WIDTH * Position::HEIGHT - 2 - nbMoves) / 2, Position::MIN_SCORE);
+    if (alpha < min) {
+        alpha = min;
+        if (alpha >= beta) {
+            return alpha;
+        }
+    }
+
+    // Try the best move of the previous search of the position first, then sort the moves by the number of
+    // winning cells they create, adding them from the edges to the center so that center columns are tried
+    // first among moves of equal score
+    // Helper threads rotate the tie-break order so that they explore the tree in a different order than the main thread
+    // The TranspositionTable entries of the children start loading meanwhile, the searches of the children at depth 0
+    // do not read them
+    BasicMoveSorter<Position::WIDTH> moves;
+    {
+        PhaseTimer timer(context.stats.moveOrderingTime);
+        int moveScores[Position::WIDTH];
+        currentPosition.moveScores(next, moveScores);
+        for (int i = Position::WIDTH; i--; ) {
+            int x = Position::orderedColumn((i + context.threadIndex) % Position::WIDTH);
+            if (next & Position::columnMask(x)) {
+                if (depth > 1) {
+                    context.transTable.prefetch(foldKey(currentPosition.canonicalKeyAfter(x)));
+                }
+                moves.add(x, x == ttMove ? std::numeric_limits<int>::max() : moveScores[x]);
+            }
+        }
+    }
+
+    int alphaOrig = alpha;
+    int bestMove = -1;
+    auto searchedDepth = [&] {
+        return context.estimateCount == estimatesBefore ? Position::WIDTH * Position::HEIGHT - nbMoves : depth;
+    };
+
+    int moveIndex = 0;  // Index of x in the search order
+    for (int x = moves.getNext(); x >= 0; x = moves.getNext(), moveIndex++) {
+        // Use the TranspositionTable in the recursive calls
+        currentPosition.play(x);
+        int score = -negamax(currentPosition, depth - 1, -beta, -alpha, context);
+        currentPosition.undo(x);
+        if (context.aborted()) {
+            return 0; // The score of an interrupted search must not reach the TranspositionTable, which outlives the search
+        }
+
+        if (score >= beta) {
+            if (SEARCH_STATS) context.stats.cutoffs[moveIndex]++;
+            PhaseTimer timer(context.stats.transTableTime);
+            context.transTable.put(tableKey(currentPosition), packEntry(score, LOWER_BOUND, searchedDepth(), nbMoves, x));
+            return score; // Beta cutoff
+        }
+
+        if (score > alpha) {
+            alpha = score; // Update alpha
+            bestMove = x;
+        }
+    }
+
+    // Store the score in the TranspositionTable once all moves have been searched
+    PhaseTimer timer(context.stats.transTableTime);
+    context.transTable.put(tableKey(currentPosition), packEntry(alpha, alpha > alphaOrig ? EXACT_SCORE : UPPER_BOUND, searchedDepth(), nbMoves, bestMove));
+
+    return alpha;
+}
+
+template<class P>
+int BasicSolver<P>::solve(const Position &initialPosition, SearchStats *stats) {
+    exploredNodeCount = 0;
+    interrupted = false;
+
+    int bookScore;
+    if (lookUpBook(openingBook, initialPosition, bookScore)) {
+        if (stats) *stats = SearchStats();
+        return bookScore;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    // Helper threads search until the calling thread has its result, their state is only allocated when there are some
+    std::atomic<bool> stop(false);
+    SearchContext context{transTable, startTime, stop, 0, verbose, false, 0, 0, SearchStats()};
+    std::vector<SearchContext> helperContexts;
+    std::vector<std::thread> helpers;
+    if (threadCount > 1) {
+        helperContexts.reserve(threadCount - 1);
+        for (unsigned int i = 1; i < threadCount; i++) {
+            helperContexts.push_back(SearchContext{transTable, startTime, stop, i, false, false, 0, 0, SearchStats()});
+        }
+        for (SearchContext &helperContext : helperContexts) {
+            helpers.emplace_back([this, &initialPosition, &helperContext] { search(initialPosition, helperContext); });
+        }
+    }
+
+    int score = search(initialPosition, context);
+
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread &helper : helpers) {
+        helper.join();
+    }
+    exploredNodeCount = context.nodeCount;
+    for (SearchContext &helperContext : helperContexts) {
+        exploredNodeCount += helperContext.nodeCount;
+        context.stats.add(helperContext.stats);
+    }
+    context.stats.nodeCount = exploredNodeCount;
+    context.stats.interrupted = interrupted = context.interrupted;
+
+    if (verbose) {
+        std::clog << "Nodes explored: " << exploredNodeCount;
+        if (context.stats.effectiveBranchingFactor() > 0) std::clog << ", effective branching factor " << context.stats.effectiveBranchingFactor();
+        if (SearchStats::COUNTED) std::clog << ", first move cutoffs " << context.stats.firstMoveCutoffRate() << ", TT hit rate " << context.stats.ttHitRate();
+        std::clog << "\n";
+    }
+    if (stats) *stats = context.stats;
+    return score;
+}
+
+template<class P>
+std::vector<int> BasicSolver<P>::solveBatch(const std::vector<Position> &positions, std::vector<unsigned long long> *nodeCounts,
+                                            std::vector<char> *interruptions) {
+    std::vector<int> scores(positions.size());
+    std::vector<unsigned long long> counts(positions.size());
+    std::vector<char> stopped(positions.size());  // Not a vector<bool>, the tasks set their flags concurrently
+    std::atomic<bool> stop(false);
+
+    if (!batchPool || batchPool->size() != threadCount) {
+        batchPool.reset(new ThreadPool(threadCount));
+    }
+    for (size_t i = 0; i < positions.size(); i++) {
+        batchPool->submit([this, &positions, &scores, &counts, &stopped, &stop, i] {
+            if (lookUpBook(openingBook, positions[i], scores[i])) {
+                return;
+            }
+            SearchContext context{transTable, std::chrono::steady_clock::now(), stop, 0, false, false, 0, 0, SearchStats()};
+            scores[i] = search(positions[i], context);
+            counts[i] = context.nodeCount;
+            stopped[i] = context.interrupted;
+        });
+    }
+    batchPool->wait();
+
+    exploredNodeCount = 0;
+    for (unsigned long long count : counts) {
+        exploredNodeCount += count;
+    }
+    if (nodeCounts) {
+        nodeCounts->swap(counts);
+    }
+    if (interruptions) {
+        interruptions->swap(stopped);
+    }
+    return scores;
+}
+
+template<class P>
+int BasicSolver<P>::search(const Position &initialPosition, SearchContext &context) noexcept {
+    if (searchMode == NULL_WINDOW) {
+        return solveNullWindow(initialPosition, context);
+    }
+    return solveIterativeDeepening(initialPosition, context);
+}
+
+template<class P>
+int BasicSolver<P>::solveIterativeDeepening(const Position &initialPosition, SearchContext &context) noexcept {
+    Position position(initialPosition);  // Searched in place
+    int bestScore = 0;  // Initialize with a neutral value
+    int maxDepth = std::min(depthLimit, static_cast<int>(Position::WIDTH * Position::HEIGHT - initialPosition.nbMoves()));
+    int depth;
+
+    for (depth = 1; depth <= maxDepth; ++depth) {
+        auto start = std::chrono::steady_clock::now();
+        unsigned long long firstNode = context.nodeCount;
+        int score = aspirationSearch(position, depth, depth > 1 ? bestScore : INVALID_SCORE, context);
+        context.recordIteration(depth, score, start, firstNode);
+
+        // An interrupted search leaves the score of the previous depth
+        if (context.aborted()) {
+            if (context.verbose && context.interrupted) std::clog << "Time's up! ";
+            break;
+        }
+
+        // Update the best score
+        bestScore = score;
+        if (context.verbose) {
+            std::clog << "Depth " << depth << " completed in "
+                      << std::chrono::duration<double, std::milli>(context.stats.iterations[context.stats.iterationCount - 1].time).count()
+                      << " ms. Nodes explored: " << context.nodeCount << "\n";
+        }
+    }
+
+    if (context.verbose) std::clog << "Completed search up to depth " << (depth - 1) << ". ";
+    return bestScore;
+}
+
+template<class P>
+int BasicSolver<P>::aspirationSearch(Position &position, int depth, int guess, SearchContext &context) noexcept {
+    int alpha = std::numeric_limits<int>::min() + 1;
+    int beta = std::numeric_limits<int>::max();
+    if (guess != INVALID_SCORE) {
+        alpha = guess - ASPIRATION_WINDOW;
+        beta = guess + ASPIRATION_WINDOW;
+    }
+    for (;;) {
+        int score = negamax(position, depth, alpha, beta, context);
+        if (context.aborted()) {
+            return score;
+        }
+        if (score <= alpha) {
+            alpha = std::numeric_limits<int>::min() + 1;  // Fail low, the score is at most score
+        } else if (score >= beta) {
+            beta = std::numeric_limits<int>::max();  // Fail high, the score is at least score
+        } else {
+            return score;
+        }
+    }
+}
+
+template<class P>
+int BasicSolver<P>::solveNullWindow(const Position &initialPosition, SearchContext &context) noexcept {
+    Position position(initialPosition);  // Searched in place
+    int nbMoves = position.nbMoves();
+    int depth = std::min(depthLimit, Position::WIDTH * Position::HEIGHT - nbMoves);
+    int min = -(Position::WIDTH * Position::HEIGHT - nbMoves) / 2;  // Lose with the opponent's next move
+    int max = (Position::WIDTH * Position::HEIGHT + 1 - nbMoves) / 2;  // Win with our next move
+
+    // Each null window search tells whether the score is above or below med, and the bounds it leaves
+    // in the TranspositionTable make the following searches cheaper
+    while (min < max) {
+        int med = min + (max - min) / 2;
+        if (med <= 0 && min / 2 < med) {
+            med = min / 2;  // Explore scores close to 0 first, they are the cheapest to refute
+        } else if (med >= 0 && max / 2 > med) {
+            med = max / 2;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        unsigned long long firstNode = context.nodeCount;
+        int score = negamax(position, depth, med, med + 1, context);
+        context.recordIteration(depth, score, start, firstNode);
+        if (context.aborted()) {
+            if (context.verbose && context.interrupted) std::clog << "Time's up! ";
+            break;
+        }
+
+        if (score <= med) {
+            max = score;
+        } else {
+            min = score;
+        }
+    }
+
+    if (context.verbose) std::clog << "Narrowed score to [" << min << ", " << max << "]. ";
+    if (min < max) {
+        // Interrupted, the initial bounds are beyond the scores of the board
+        return std::max(Position::MIN_SCORE, std::min(Position::MAX_SCORE, min + (max - min) / 2));
+    }
+    return min;
+}
+
+template<class P>
+typename BasicSolver<P>::Analysis BasicSolver<P>::analyze(const Position &position) {
+    exploredNodeCount = 0;
+    int nbMoves = position.nbMoves();
+    int remaining = Position::WIDTH * Position::HEIGHT - nbMoves;
+
+    Analysis analysis;
+    analysis.score = 0;
+    analysis.bestMove = -1;
+    analysis.principalVariationLength = 0;
+    analysis.depth = 0;
+    analysis.exact = remaining == 0;
+    for (int x = 0; x < Position::WIDTH; x++) {
+        analysis.columnScores[x] = INVALID_SCORE;
+        // Until an iteration completes, the best move is the playable column closest to the center
+        int column = Position::orderedColumn(x);
+        if (analysis.bestMove < 0 && position.canPlay(column)) {
+            analysis.bestMove = column;
+        }
+    }
+
+    std::atomic<bool> stop(false);
+    SearchContext context{transTable, std::chrono::steady_clock::now(), stop, 0, false, false, 0, 0, SearchStats()};
+    int maxDepth = std::min(depthLimit, remaining);
+
+    Position nextPosition(position);  // Children of the position, searched in place
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        int columnScores[Position::WIDTH];
+        bool searched = false;  // Whether a column was searched rather than found in the opening book or won at once
+        for (int x = 0; x < Position::WIDTH && !context.aborted(); x++) {
+            columnScores[x] = INVALID_SCORE;
+            if (!position.canPlay(x)) {
+                continue;
+            }
+            if (position.isWinningMove(x)) {
+                columnScores[x] = (Position::WIDTH * Position::HEIGHT + 1 - nbMoves) / 2;
+                continue;
+            }
+            nextPosition.play(x);
+            int bookScore;
+            if (lookUpBook(openingBook, nextPosition, bookScore)) {
+                columnScores[x] = -bookScore;
+            } else {
+                int guess = depth > 1 && analysis.columnScores[x] != INVALID_SCORE ? -analysis.columnScores[x] : INVALID_SCORE;
+                columnScores[x] = -aspirationSearch(nextPosition, depth - 1, guess, context);
+                searched = true;
+            }
+            nextPosition.undo(x);
+        }
+        if (context.aborted()) {
+            break;  // Keep the results of the previous iteration
+        }
+
+        // Ties go to the column closest to the center
+        int best = -1;
+        for (int x = 0; x < Position::WIDTH; x++) {
+            if (columnScores[x] != INVALID_SCORE &&
+                (best < 0 || columnScores[x] > columnScores[best] ||
+                 (columnScores[x] == columnScores[best] && std::abs(2 * x - Position::WIDTH + 1) < std::abs(2 * best - Position::WIDTH + 1)))) {
+                best = x;
+            }
+        }
+        std::copy(columnScores, columnScores + Position::WIDTH, analysis.columnScores);
+        analysis.bestMove = best;
+        analysis.score = columnScores[best];
+        analysis.depth = depth;
+        analysis.exact = depth == remaining || !searched;
+
+        analysis.principalVariation[0] = best;
+        analysis.principalVariationLength = 1;
+        if (!position.isWinningMove(best)) {
+            nextPosition.play(best);
+            analysis.principalVariationLength += principalVariation(nextPosition, -analysis.score, depth - 1, analysis.principalVariation + 1);
+            nextPosition.undo(best);
+        }
+        if (progressCallback) {
+            progressCallback(analysis);
+        }
+
+        if (!searched) {
+            break;  // Deeper iterations would give the same exact scores
+        }
+    }
+
+    exploredNodeCount = context.nodeCount;
+    return analysis;
+}
+
+template<class P>
+int BasicSolver<P>::principalVariation(Position position, int score, int depth, int *moves) const noexcept {
+    int length = 0;
+    for (; depth > 0; depth--) {
+        int nbMoves = position.nbMoves();
+        if (nbMoves >= Position::WIDTH * Position::HEIGHT) {
+            break;
+        }
+
+        if (position.canWinNext()) {
+            for (int x = 0; x < Position::WIDTH; x++) {
+                if (position.canPlay(x) && position.isWinningMove(x)) {
+                    moves[length++] = x;
+                    break;
+                }
+            }
+            break;  // The game ends with this move
+        }
+
+        int move = -1;
+        typename Position::bitboard_t next = position.possibleNonLosingMoves();
+        for (int x = 0; x < Position::WIDTH && move < 0; x++) {
+            if (!position.canPlay(x)) {
+                continue;
+            }
+            if (next == 0) {
+                move = x;  // Every move loses, any of them is part of the variation
+                continue;
+            }
+            if (!(next & Position::columnMask(x))) {
+                continue;
+            }
+
+            position.play(x);
+            int nextDepth = std::min(depth - 1, Position::WIDTH * Position::HEIGHT - 1 - nbMoves);
+            if (position.possibleNonLosingMoves() == 0) {
+                // Scored by negamax() without reaching the TranspositionTable
+                if ((Position::WIDTH * Position::HEIGHT - 1 - nbMoves) / 2 >= score) {
+                    move = x;
+                }
+            } else if (nextDepth == 0) {
+                // Scored by negamax() without searching: a draw on a full board, the endgame table or an estimate
+                int leafScore = 0;
+                if (position.nbMoves() < Position::WIDTH * Position::HEIGHT && !lookUpEndgame(endgameTable, position, leafScore)) {
+                    leafScore = position.evaluate();
+                }
+                if (-leafScore >= score) {
+                    move = x;
+                }
+            } else {
+                // A move is best if the score of the opponent after it is at most -score
+                typename TransTable::value_t entry = transTable.get(tableKey(position));
+                if (entry != 0 && entryDepth(entry) >= nextDepth && entryBound(entry) != LOWER_BOUND &&
+                    -entryScore(entry) >= score) {
+                    move = x;
+                }
+            }
+            position.undo(x);
+        }
+        if (move < 0) {
+            break;  // The entries leading further have been replaced
+        }
+
+        moves[length++] = move;
+        position.play(move);
+        score = -score;
+    }
+    return length;
+}
+
+// The standard board, and the research variants
+template class GameSolver::Connect4::BasicSolver<Position>;
+template class GameSolver::Connect4::BasicSolver<BasicPosition<6, 5>>;
+template class GameSolver::Connect4::BasicSolver<BasicPosition<8, 7>>;
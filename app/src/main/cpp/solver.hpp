@@ -0,0 +1,585 @@
+#ifndef SOLVER_HPP
+#define SOLVER_HPP
+
+#include "board.hpp"
+#include "hash_table.hpp"
+#include "thread_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * Whether the searches count their cutoffs and TranspositionTable lookups for BasicSolver::SearchStats,
+ * by default for debug builds only. Define it to 1 to count them in release builds too.
+ */
+#ifndef SEARCH_STATS
+#ifdef NDEBUG
+#define SEARCH_STATS 0
+#else
+#define SEARCH_STATS 1
+#endif
+#endif
+
+/**
+ * Whether the searches time their move ordering, TranspositionTable accesses and evaluations for
+ * BasicSolver::SearchStats. Off by default in every build: reading the clock in each node costs more
+ * than the phases timed on phones, so timed searches are only compared with each other.
+ */
+#ifndef SEARCH_TIMERS
+#define SEARCH_TIMERS 0
+#endif
+
+namespace GameSolver {
+    namespace Connect4 {
+
+        class OpeningBook;
+        class EndgameTable;
+
+        /**
+        * BasicSolver class is responsible for solving the Connect 4 game using the Negamax algorithm.
+        * Its member functions are instantiated by the library for the standard board (Connect4Solver)
+        * and for the 6x5 and 8x7 research variants.
+        *
+        * The memory of the searches is reserved at construction, within a limit and optionally in memory given
+        * by the caller: single threaded solve() and analyze() calls do not allocate, and the search itself does
+        * not throw. Helper threads of setThreadCount() and the workers of solveBatch() are allocated by the calls
+        * starting them.
+        * @tparam P The BasicPosition of the board geometry to solve.
+        */
+        template<class P>
+        class BasicSolver {
+        public:
+            typedef P Position;  // Positions of the board geometry solved
+
+            /**
+            * Strategy used by solve() to drive the Negamax search.
+            */
+            enum SearchMode {
+                ITERATIVE_DEEPENING,  // Full window searches of increasing depth up to the depth limit
+                NULL_WINDOW           // Binary search of the score with null window searches at the depth limit
+            };
+
+            static const int INVALID_SCORE = std::numeric_limits<int>::min();  // Score of the columns that cannot be played
+
+            /**
+            * Result of analyze(), taken from its last completed iteration.
+            * Columns are numbered from 0 for the leftmost one.
+            */
+            struct Analysis {
+                int score;  // Score of the position
+                int bestMove;  // Column of the best move, -1 only if the board is full
+                int columnScores[Position::WIDTH];  // Score of playing each column, INVALID_SCORE for full columns
+                int principalVariation[Position::WIDTH * Position::HEIGHT];  // Expected moves, starting with bestMove
+                int principalVariationLength;  // Number of moves of principalVariation
+                int depth;  // Depth of the last completed iteration, 0 if none completed in time
+                bool exact;  // Whether the scores are exact rather than estimated at a limited depth
+            };
+
+            /**
+            * Profile of a solve() call. Its iterations are always recorded, the counters of the nodes only with
+            * SEARCH_STATS and the time of their phases only with SEARCH_TIMERS, they are 0 otherwise, see COUNTED
+            * and TIMED. Counters and times are summed over all search threads.
+            */
+            struct SearchStats {
+                static constexpr bool COUNTED = SEARCH_STATS;  // Whether the counters of the nodes are actual counts
+                static constexpr bool TIMED = SEARCH_TIMERS;  // Whether the phases of the nodes are timed
+                static const int MAX_ITERATIONS = Position::WIDTH * Position::HEIGHT;
+
+                /**
+                * One search of the position by the calling thread: a depth of iterative deepening, including
+                * the searches of its aspiration windows, or one null window search.
+                */
+                struct Iteration {
+                    int depth;  // Depth of the search
+                    int score;  // Score found, meaningless if the search did not complete
+                    bool completed;  // Whether the search completed within the limits
+                    unsigned long long nodeCount;  // Nodes explored by the calling thread during the search
+                    std::chrono::steady_clock::duration time;  // Duration of the search
+                };
+
+                Iteration iterations[MAX_ITERATIONS];
+                int iterationCount;  // Number of iterations, only the last one may be incomplete
+                bool interrupted;  // Whether the time limit or the cancel flag stopped the search, see wasInterrupted()
+                unsigned long long nodeCount;  // Nodes explored, see getExploredNodeCount()
+                unsigned long long cutoffs[Position::WIDTH];  // Beta cutoffs by index of the move in the search order, 0 for the first move searched
+                unsigned long long ttProbes;  // Lookups of the TranspositionTable by the nodes searched
+                unsigned long long ttHits;  // Lookups finding an entry, of any depth
+                unsigned long long ttCutoffs;  // Lookups finding bounds deep enough to end the search of the node
+                std::chrono::steady_clock::duration moveOrderingTime;  // Generation, scoring and sorting of the moves
+                std::chrono::steady_clock::duration transTableTime;  // Lookups and stores of the TranspositionTable
+                std::chrono::steady_clock::duration evaluationTime;  // Estimates of the positions at the depth limit
+
+                unsigned long long cutoffCount() const {
+                    unsigned long long count = 0;
+                    for (unsigned long long c : cutoffs) {
+                        count += c;
+                    }
+                    return count;
+                }
+
+                /**
+                 * @return The share of the beta cutoffs caused by the first move searched, 1 for a perfect move ordering.
+                 */
+                double firstMoveCutoffRate() const {
+                    return cutoffCount() > 0 ? static_cast<double>(cutoffs[0]) / cutoffCount() : 0.0;
+                }
+
+                double ttHitRate() const {
+                    return ttProbes > 0 ? static_cast<double>(ttHits) / ttProbes : 0.0;
+                }
+
+                /**
+                 * Computes the growth of the number of nodes per added depth between the last two completed
+                 * iterations of different depths, so only for iterative deepening.
+                 * @return The effective branching factor, 0 without two such iterations.
+                 */
+                double effectiveBranchingFactor() const {
+                    const Iteration *last = nullptr;
+                    for (int i = iterationCount; i--; ) {
+                        const Iteration &iteration = iterations[i];
+                        if (!iteration.completed || iteration.nodeCount == 0) {
+                            continue;
+                        }
+                        if (!last) {
+                            last = &iteration;
+                        } else if (iteration.depth < last->depth) {
+                            return std::pow(static_cast<double>(last->nodeCount) / iteration.nodeCount,
+                                            1.0 / (last->depth - iteration.depth));
+                        }
+                    }
+                    return 0.0;
+                }
+
+                /**
+                 * Adds the counters and times of another profile, e.g. to sum the profiles of several solve() calls.
+                 * Iterations are kept.
+                 */
+                void add(const SearchStats &other) {
+                    nodeCount += other.nodeCount;
+                    for (int i = 0; i < Position::WIDTH; i++) {
+                        cutoffs[i] += other.cutoffs[i];
+                    }
+                    ttProbes += other.ttProbes;
+                    ttHits += other.ttHits;
+                    ttCutoffs += other.ttCutoffs;
+                    moveOrderingTime += other.moveOrderingTime;
+                    transTableTime += other.transTableTime;
+                    evaluationTime += other.evaluationTime;
+                }
+            };
+
+        private:
+            // Keys of more than 63 bits are folded by tableKey() to fit the TranspositionTable
+            static const unsigned TABLE_KEY_BITS = Position::KEY_BITS < 64 ? Position::KEY_BITS : 63;
+
+            // 32 bits partial keys, exact for the standard board with tables of more than 2^17 entries
+            typedef TranspositionTable<(TABLE_KEY_BITS < 32 ? TABLE_KEY_BITS : 32), 16, TABLE_KEY_BITS> TransTable;
+
+            /**
+             * Computes the TranspositionTable key of a position, shared with its mirror.
+             * Keys of boards of more than 63 bits are hashed, different positions may then share a key.
+             */
+            static uint64_t tableKey(const Position &position) {
+                return foldKey(position.canonicalKey());
+            }
+
+            static uint64_t foldKey(uint64_t key) {
+                return TABLE_KEY_BITS == Position::KEY_BITS ? key : (key ^ key >> 63) & ((UINT64_C(1) << 63) - 1);
+            }
+
+#ifdef __SIZEOF_INT128__
+            static uint64_t foldKey(__uint128_t key) {
+                return foldKey(static_cast<uint64_t>(static_cast<uint64_t>(key) ^ static_cast<uint64_t>(key >> 64) * 0x9E3779B97F4A7C15ULL));
+            }
+#endif
+
+            /**
+             * Kind of score stored in a transposition table entry.
+             * 0 is never used so that a stored entry is never mistaken for a missing one.
+             */
+            enum Bound {
+                UPPER_BOUND = 1,  // The score is at most the stored value (all moves failed low)
+                LOWER_BOUND = 2,  // The score is at least the stored value (beta cutoff)
+                EXACT_SCORE = 3   // The stored value is the score
+            };
+
+            static_assert(Position::MAX_SCORE - Position::MIN_SCORE + 1 < 64 && Position::WIDTH <= 8,
+                          "Scores and moves of the board do not fit a transposition table value");
+
+            static const int FULL_DEPTH = 31;  // Stored depth of the searches reaching the end of the game
+
+            // Board and layout of the transposition table values, checked when loading saved caches
+            static const uint32_t CACHE_FORMAT = Position::WIDTH | Position::HEIGHT << 8 | 1 << 16;
+
+            /**
+             * Packs a search result into a transposition table value:
+             * bits 0-5 hold score - MIN_SCORE + 1, bits 6-7 the bound, bits 8-12 the searched depth and
+             * bits 13-15 the column of the best move, which upper bounds do not have.
+             * Searches reaching the end of the game are stored with FULL_DEPTH and are valid at any depth.
+             * Deeper searches that do not reach it are stored as FULL_DEPTH - 1, they are then only
+             * reused by shallower searches.
+             * @param nbMoves The number of moves of the searched position.
+             * @param move The column of the best move, ignored for upper bounds.
+             */
+            static typename TransTable::value_t packEntry(int score, Bound bound, int depth, int nbMoves, int move) {
+                assert(score >= Position::MIN_SCORE && score <= Position::MAX_SCORE);
+                int storedDepth = depth >= Position::WIDTH * Position::HEIGHT - nbMoves ? FULL_DEPTH : std::min(depth, FULL_DEPTH - 1);
+                return static_cast<typename TransTable::value_t>((score - Position::MIN_SCORE + 1) | (bound << 6) | (storedDepth << 8) |
+                                                                 ((bound == UPPER_BOUND ? 0 : move) << 13));
+            }
+
+            static int entryScore(typename TransTable::value_t entry) {
+                return (entry & 63) + Position::MIN_SCORE - 1;
+            }
+
+            static Bound entryBound(typename TransTable::value_t entry) {
+                return static_cast<Bound>((entry >> 6) & 3);
+            }
+
+            static int entryDepth(typename TransTable::value_t entry) {
+                int depth = (entry >> 8) & 31;
+                return depth == FULL_DEPTH ? Position::WIDTH * Position::HEIGHT : depth;
+            }
+
+            /**
+             * @return the column of the best move of an entry, -1 for upper bounds.
+             */
+            static int entryMove(typename TransTable::value_t entry) {
+                return entryBound(entry) == UPPER_BOUND ? -1 : entry >> 13;
+            }
+
+            /**
+            * State of one search thread. All the threads of a solve() share the solver's TranspositionTable.
+            */
+            struct SearchContext {
+                TransTable &transTable;  // TranspositionTable shared by all the threads
+                std::chrono::steady_clock::time_point startTime;  // Start of the solve() call
+                const std::atomic<bool> &stop;  // Set when the search has to stop
+                unsigned int threadIndex;  // 0 for the main thread, helpers diversify their move order with it
+                bool verbose;  // Whether this thread reports the progress of its search on std::clog
+                bool interrupted;  // Set by negamax() when the time limit is exceeded or the search is cancelled, the search results are then meaningless
+                unsigned long long nodeCount;  // Number of nodes explored by this thread
+                unsigned long long estimateCount;  // Number of depth limited scores used by this thread, from evaluate() or the TranspositionTable
+                SearchStats stats;  // Profile of the searches of this thread
+
+                /**
+                 * @return true if the search has to unwind, its scores are then meaningless.
+                 */
+                bool aborted() const {
+                    return interrupted || stop.load(std::memory_order_relaxed);
+                }
+
+                /**
+                 * Records a search of the position started at a time and node count of this thread.
+                 */
+                void recordIteration(int depth, int score, std::chrono::steady_clock::time_point start, unsigned long long firstNode) {
+                    if (stats.iterationCount < SearchStats::MAX_ITERATIONS) {
+                        stats.iterations[stats.iterationCount++] = typename SearchStats::Iteration{
+                                depth, score, !aborted(), nodeCount - firstNode, std::chrono::steady_clock::now() - start};
+                    }
+                }
+            };
+
+            static constexpr unsigned long long TIME_CHECK_INTERVAL = 4096;  // Nodes between two reads of the clock and cancellation flag, a power of two
+            static const int ASPIRATION_WINDOW = 2;  // Distance from the score of the previous iteration to the bounds of the first window of aspirationSearch()
+
+            std::unique_ptr<TransTable> ownTable;  // TranspositionTable of the solver, null for solvers sharing a Cache
+            TransTable &transTable;  // Kept across solve() calls, positions of the same game reuse the results of each other
+            unsigned long long exploredNodeCount = 0;  // Counter for the number of nodes explored
+            bool interrupted = false;  // Whether the last solve() was stopped before its result
+            std::chrono::steady_clock::duration timeLimit;  // Time limit for the solver
+            int depthLimit;  // Depth limit for the solver
+            SearchMode searchMode;  // Strategy used to drive the search
+            const OpeningBook *openingBook = nullptr;  // Exact scores of early positions, consulted before searching
+            const EndgameTable *endgameTable = nullptr;  // Exact scores of late positions, consulted by negamax()
+            unsigned int threadCount = 1;  // Number of search threads, including the calling thread
+            bool verbose = false;  // Whether solve() reports the progress of its searches
+            std::unique_ptr<ThreadPool> batchPool;  // Workers of solveBatch(), started by its first call
+            const std::atomic<bool> *cancelFlag = nullptr;  // Interrupts the searches once set, if not null
+            std::function<void(const Analysis&)> progressCallback;  // Called by analyze() after each completed iteration
+
+            /**
+            * Implementation of the Negamax algorithm with alpha-beta pruning.
+            * Moves are played and undone in place, currentPosition is restored when the function returns.
+            * Returns a meaningless score once the search is aborted, callers must check context.aborted() before using the score.
+            */
+            int negamax(Position &currentPosition, int depth, int alpha, int beta, SearchContext &context) noexcept;
+
+            /**
+            * Runs the search strategy selected by searchMode for one thread.
+            */
+            int search(const Position &initialPosition, SearchContext &context) noexcept;
+
+            /**
+            * Finds the score with Negamax searches of increasing depth, see aspirationSearch().
+            */
+            int solveIterativeDeepening(const Position &initialPosition, SearchContext &context) noexcept;
+
+            /**
+            * Searches a position with a narrow window around the score of a shallower search, and searches
+            * it again with the failing side of the window opened when the score falls outside of it.
+            * The bounds and best moves left in the TranspositionTable by the shallower search make the
+            * search of the narrow window cheap when the score changes little from one depth to the next.
+            * @param guess The score of the shallower search, INVALID_SCORE to search with a full window.
+            * @return The exact score at the depth, meaningless if the search is aborted.
+            */
+            int aspirationSearch(Position &position, int depth, int guess, SearchContext &context) noexcept;
+
+            /**
+            * Finds the score by bisection of the score range with null window Negamax searches.
+            */
+            int solveNullWindow(const Position &initialPosition, SearchContext &context) noexcept;
+
+            /**
+            * Follows the best moves stored in the TranspositionTable from a position.
+            * @param position The position the moves start from.
+            * @param score The score of the position.
+            * @param depth The depth the position was searched to.
+            * @param moves Filled with the columns of the moves.
+            * @return The number of moves found.
+            */
+            int principalVariation(Position position, int score, int depth, int *moves) const noexcept;
+
+        public:
+            typedef typename TransTable::Stats CacheStats;  // Usage of the TranspositionTable
+            typedef TransTable Cache;  // TranspositionTable of the solvers, which several solvers may share
+
+            static constexpr size_t DEFAULT_MEMORY_LIMIT = TransTable::DEFAULT_BUDGET_BYTES;  // 8 MB, suitable for phones
+
+            /**
+            * Constructor for BasicSolver.
+            * @param timeLimit The time limit for the solver.
+            * @param depthLimit The depth limit for the solver.
+            * @param searchMode The strategy used to drive the search.
+            * @param memoryLimit The bytes of memory reserved for the searches, held by the TranspositionTable.
+            * @param memory Memory of memoryLimit bytes given by the caller for the searches, e.g. a part of an arena shared
+            *               by several solvers, which must outlive the solver, or nullptr for the solver to map its own.
+            * @throw std::bad_alloc if the memory cannot be reserved.
+            */
+            explicit BasicSolver(std::chrono::steady_clock::duration timeLimit = std::chrono::steady_clock::duration::max(),
+                                    int depthLimit = std::numeric_limits<int>::max(),
+                                    SearchMode searchMode = ITERATIVE_DEEPENING,
+                                    size_t memoryLimit = DEFAULT_MEMORY_LIMIT, void *memory = nullptr)
+                    : ownTable(new TransTable(memoryLimit, memory)), transTable(*ownTable),
+                      timeLimit(timeLimit), depthLimit(depthLimit), searchMode(searchMode) {}
+
+            /**
+            * Constructor for a BasicSolver sharing a Cache with other solvers, possibly searching on other threads, e.g.
+            * one solver per worker thread of a server: the solvers then use the memory of the Cache only, and the
+            * positions of every game reuse the results of each other. The methods of the solver managing its cache,
+            * such as clearCache() and loadCache(), act on the Cache of all the solvers.
+            * @param cache The Cache, it must outlive the solver.
+            */
+            explicit BasicSolver(Cache &cache,
+                                 std::chrono::steady_clock::duration timeLimit = std::chrono::steady_clock::duration::max(),
+                                 int depthLimit = std::numeric_limits<int>::max(),
+                                 SearchMode searchMode = ITERATIVE_DEEPENING)
+                    : transTable(cache), timeLimit(timeLimit), depthLimit(depthLimit), searchMode(searchMode) {}
+
+            /**
+             * Solves the Connect 4 game for the given initial position.
+             * @param initialPosition The initial position of the game.
+             * @param stats If not null, set to the profile of the search, without iterations for positions
+             *              of the opening book.
+             * @return The score of the best move, an estimate if the search was interrupted, see wasInterrupted().
+             */
+            int solve(const Position &initialPosition, SearchStats *stats = nullptr);
+
+            /**
+             * Scores every move of a position with iterative deepening, using the calling thread only.
+             * Each iteration searches every column to the same depth, and an iteration interrupted by the time
+             * limit is discarded, so the result is that of the last completed iteration whenever the time expires.
+             * @param position The position to analyze.
+             * @return The scores of the moves, the best one and the principal variation.
+             */
+            Analysis analyze(const Position &position);
+
+            /**
+             * Finds the best move of a position within the time and depth limits, see analyze().
+             * @param position The position to play from.
+             * @return The column of the best move, -1 only if the board is full.
+             */
+            int bestMove(const Position &position) {
+                return analyze(position).bestMove;
+            }
+
+            /**
+             * Solves many positions in parallel.
+             * Each position is searched by a single thread, with up to getThreadCount() positions solved
+             * at the same time by a work-stealing ThreadPool. All the positions share the solver's TranspositionTable,
+             * so positions of the same game reuse the results of each other.
+             * @param positions The positions to solve.
+             * @param nodeCounts If not null, set to the number of nodes explored for each position.
+             * @param interruptions If not null, set to whether the search of each position was interrupted, see wasInterrupted().
+             * @return The score of each position, in the order of positions.
+             */
+            std::vector<int> solveBatch(const std::vector<Position> &positions,
+                                        std::vector<unsigned long long> *nodeCounts = nullptr,
+                                        std::vector<char> *interruptions = nullptr);
+
+            /**
+             * Forgets the results of previous searches, in constant time.
+             * Results stay valid for later positions and are kept by default: solving consecutive positions of
+             * a game reuses them. Clearing the cache makes node counts independent of the previous calls.
+             */
+            void clearCache() {
+                transTable.clear();
+            }
+
+            /**
+             * Gets the usage of the TranspositionTable since the solver was built or resetCacheStats() was called,
+             * over all search threads. Lookups and stores are only counted with TRANSPOSITION_TABLE_STATS,
+             * the default of debug builds, see CacheStats.
+             * Occupancy is counted over the whole table, in linear time.
+             */
+            CacheStats getCacheStats() const {
+                return transTable.getStats();
+            }
+
+            void resetCacheStats() {
+                transTable.resetStats();
+            }
+
+            /**
+             * Saves the results of the searches since the last clearCache() to a file, so that a later process
+             * starts with them, see loadCache() and mapCache().
+             * @param path The path of the file, replaced once the new file is complete.
+             * @return true if the file was successfully written.
+             */
+            bool saveCache(const char *path) const {
+                return transTable.save(path, CACHE_FORMAT);
+            }
+
+            /**
+             * Replaces the results of previous searches with those saved by saveCache() from a solver of the same
+             * board and cache size.
+             * @return true if the file was loaded, the results of previous searches are kept otherwise.
+             */
+            bool loadCache(const char *path) {
+                return transTable.load(path, CACHE_FORMAT);
+            }
+
+            /**
+             * Maps a file saved by saveCache() from a solver of the same board and cache size as read-only results,
+             * consulted by the searches when their own results have none, without copying the file.
+             * Processes mapping the same file share its memory. The file must not be truncated or written while it is
+             * mapped, saveCache() replaces files without writing them.
+             * @param path The path of the file, or nullptr to unmap the current one.
+             * @return true if the file was mapped.
+             */
+            bool mapCache(const char *path) {
+                if (!path) {
+                    transTable.unmapSnapshot();
+                    return false;
+                }
+                return transTable.mapSnapshot(path, CACHE_FORMAT);
+            }
+
+            /**
+             * Sets the opening book consulted by solve() before searching.
+             * Positions found in the book are not searched and get their exact score whatever the limits.
+             * @param book The opening book, it must outlive its use by the solver, or nullptr to search every position.
+             */
+            void setOpeningBook(const OpeningBook *book) {
+                openingBook = book;
+            }
+
+            /**
+             * Sets the endgame table probed by the searches.
+             * Searches stop at the positions found in the table and take their exact score whatever the depth limit,
+             * so depth-limited searches reaching the table score their leaves exactly.
+             * @param table The endgame table, it must outlive its use by the solver, or nullptr to search every position.
+             */
+            void setEndgameTable(const EndgameTable *table) {
+                endgameTable = table;
+            }
+
+            /**
+             * Sets the time limit of the following searches.
+             * @param limit The time limit, measured from the start of each solve(), solveBatch() task or analyze().
+             */
+            void setTimeLimit(std::chrono::steady_clock::duration limit) {
+                timeLimit = limit;
+            }
+
+            /**
+             * Sets a flag letting another thread interrupt the searches.
+             * Once the flag is set, searches stop within TIME_CHECK_INTERVAL nodes as if their time limit expired.
+             * The solver never clears the flag, the caller does it before the next search.
+             * @param flag The flag, it must outlive its use by the solver, or nullptr to disable cancellation.
+             */
+            void setCancelFlag(const std::atomic<bool> *flag) {
+                cancelFlag = flag;
+            }
+
+            /**
+             * Sets a function called by analyze() on its thread with the result of each completed iteration.
+             * @param callback The function, or an empty function to disable progress reports.
+             */
+            void setProgressCallback(std::function<void(const Analysis&)> callback) {
+                progressCallback = std::move(callback);
+            }
+
+            /**
+             * Sets whether solve() reports each iteration of its search and its node count on std::clog.
+             * Reports are off by default, they cost as much as the search of easy positions.
+             */
+            void setVerbose(bool enabled) {
+                verbose = enabled;
+            }
+
+            /**
+             * Sets the number of threads used by solve() and solveBatch().
+             * Helper threads run the same search as the calling thread ("Lazy SMP") and share its
+             * TranspositionTable, so that each thread mostly finds results stored by the others.
+             * @param count The number of search threads including the calling thread, at least 1.
+             */
+            void setThreadCount(unsigned int count) {
+                threadCount = std::max(count, 1u);
+            }
+
+            /**
+             * @return The number of threads used by solve() and solveBatch().
+             */
+            unsigned int getThreadCount() const {
+                return threadCount;
+            }
+
+            /**
+             * @return The bytes of memory reserved for the searches, at most the memory limit of the constructor,
+             *         or the memory of the shared Cache.
+             */
+            size_t getMemoryUsage() const {
+                return transTable.getMemoryUsage();
+            }
+
+            /**
+             * Gets the count of explored nodes during the solving process, summed over all search threads.
+             * @return The count of explored nodes.
+             */
+            unsigned long long getExploredNodeCount() const {
+                return exploredNodeCount;
+            }
+
+            /**
+             * Tells whether the last solve() was stopped by the time limit or the cancel flag. Its score is then
+             * only an estimate within [MIN_SCORE, MAX_SCORE]: the score of the last completed depth for iterative
+             * deepening, or the middle of the narrowed score range for null window searches.
+             */
+            bool wasInterrupted() const {
+                return interrupted;
+            }
+        };
+
+        typedef BasicSolver<Position> Connect4Solver;  // Solver of the standard board
+
+    } // namespace Connect4
+} // namespace GameSolver
+
+#endif
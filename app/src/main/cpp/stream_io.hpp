@@ -0,0 +1,265 @@
+#ifndef STREAM_IO_HPP
+#define STREAM_IO_HPP
+
+#include "mapped_file.hpp"
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace GameSolver { namespace Connect4 {
+
+        /**
+         * Reads a file descriptor without copying it when possible.
+         *
+         * Regular files are memory-mapped, other inputs such as pipes and terminals are read by large
+         * blocks into a buffer reused for the whole input. The data is consumed from the front, and
+         * fill() makes more of it available after the data not consumed yet.
+         */
+        class InputStream {
+        public:
+            static const size_t BLOCK_SIZE = 1 << 20;  // Bytes requested by each read() of non-regular inputs
+
+            /**
+             * @param fd: file descriptor open for reading, left open by the stream.
+             * @param beforeRead: called before each blocking read() with arg, e.g. to flush the output
+             *                    answering the data read so far, or nullptr.
+             * @param arg: argument of beforeRead.
+             */
+            explicit InputStream(int fd, void (*beforeRead)(void*) = nullptr, void *arg = nullptr)
+                    : fd{fd}, beforeRead{beforeRead}, arg{arg}, begin{nullptr}, end{nullptr}, eof{false}
+            {
+                struct stat st;
+                if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+                    off_t offset = lseek(fd, 0, SEEK_CUR);  // the descriptor may have been read already
+                    if(offset >= 0 && offset < st.st_size && file.open(fd, offset, st.st_size - offset)) {
+                        begin = file.data();
+                        end = begin + file.size();
+                        eof = true;
+                    }
+                }
+            }
+
+            /**
+             * @return the first byte not consumed yet, valid until the next call to fill().
+             */
+            const char *data() const
+            {
+                return begin;
+            }
+
+            /**
+             * @return the number of bytes available from data().
+             */
+            size_t size() const
+            {
+                return end - begin;
+            }
+
+            /**
+             * Consumes bytes from the front of the available data.
+             */
+            void consume(size_t count)
+            {
+                begin += count;
+            }
+
+            /**
+             * Makes more data available after the data not consumed yet, which may move.
+             * @return false once the input is exhausted or cannot be read, the available data then stays the same.
+             */
+            bool fill()
+            {
+                if(eof) return false;
+                size_t pending = end - begin;
+                if(buffer.size() < pending + BLOCK_SIZE) {
+                    std::vector<char> larger(pending + BLOCK_SIZE);  // only grows when more than a block is pending
+                    if(pending) std::memcpy(larger.data(), begin, pending);
+                    buffer.swap(larger);
+                } else if(pending) {
+                    std::memmove(buffer.data(), begin, pending);
+                }
+                if(beforeRead) beforeRead(arg);
+                ssize_t count;
+                do {
+                    count = ::read(fd, buffer.data() + pending, BLOCK_SIZE);
+                } while(count < 0 && errno == EINTR);
+                eof = count <= 0;
+                begin = buffer.data();
+                end = begin + pending + (count > 0 ? count : 0);
+                return !eof;
+            }
+
+            InputStream(const InputStream&) = delete;
+            InputStream& operator=(const InputStream&) = delete;
+
+        private:
+            int fd;
+            void (*beforeRead)(void*);
+            void *arg;
+            MappedFile file;           // mapping of regular inputs
+            std::vector<char> buffer;  // block of other inputs, starting with the data pending from the previous block
+            const char *begin;         // first byte not consumed yet
+            const char *end;           // end of the mapping or of the data of the buffer
+            bool eof;                  // whether the data past end is exhausted
+        };
+
+        /**
+         * Reads the lines of a file descriptor, see InputStream.
+         * Lines of regular files point into their mapping. Lines stay valid until the next call to next(),
+         * they are not null-terminated and do not include their '\n'.
+         */
+        class LineReader {
+        public:
+            static const size_t BLOCK_SIZE = InputStream::BLOCK_SIZE;
+
+            explicit LineReader(int fd, void (*beforeRead)(void*) = nullptr, void *arg = nullptr)
+                    : input{fd, beforeRead, arg}, scanned{0} {}
+
+            /**
+             * Gets the next line.
+             * @param line: set to the first character of the line.
+             * @param length: set to the number of characters of the line.
+             * @return false once the input is exhausted or cannot be read.
+             */
+            bool next(const char *&line, size_t &length)
+            {
+                for(;;) {
+                    // the characters scanned by previous calls hold no '\n'
+                    const char *newline = input.size() > scanned ?
+                            static_cast<const char*>(std::memchr(input.data() + scanned, '\n', input.size() - scanned)) : nullptr;
+                    if(newline) {
+                        line = input.data();
+                        length = newline - line;
+                        input.consume(length + 1);
+                        scanned = 0;
+                        return true;
+                    }
+                    scanned = input.size();
+                    if(!input.fill()) {
+                        if(input.size() == 0) return false;
+                        line = input.data();  // last line without '\n'
+                        length = input.size();
+                        input.consume(length);
+                        scanned = 0;
+                        return true;
+                    }
+                }
+            }
+
+        private:
+            InputStream input;
+            size_t scanned;  // number of available characters known to hold no '\n'
+        };
+
+        /**
+         * Buffers text written to a file descriptor and writes it by large blocks.
+         * Numbers are formatted without locale or stream state, the buffer is written when it is
+         * full, by flush() and by the destructor.
+         */
+        class BufferedWriter {
+        public:
+            static const size_t CAPACITY = 1 << 16;
+
+            explicit BufferedWriter(int fd) : fd{fd}, size{0}, failed{false} {}
+
+            ~BufferedWriter()
+            {
+                flush();
+            }
+
+            BufferedWriter& write(const char *text, size_t length)
+            {
+                if(size + length > CAPACITY) {
+                    flush();
+                    if(length > CAPACITY) {
+                        writeAll(text, length);
+                        return *this;
+                    }
+                }
+                std::memcpy(data + size, text, length);
+                size += length;
+                return *this;
+            }
+
+            BufferedWriter& write(char c)
+            {
+                if(size == CAPACITY) flush();
+                data[size++] = c;
+                return *this;
+            }
+
+            BufferedWriter& write(int value)
+            {
+                return write(static_cast<long long>(value));
+            }
+
+            BufferedWriter& write(long long value)
+            {
+                char digits[24];
+                char *p = digits + sizeof(digits);
+                unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : value;
+                do {
+                    *--p = static_cast<char>('0' + magnitude % 10);
+                    magnitude /= 10;
+                } while(magnitude);
+                if(value < 0) *--p = '-';
+                return write(p, digits + sizeof(digits) - p);
+            }
+
+            BufferedWriter& write(unsigned long long value)
+            {
+                char digits[24];
+                char *p = digits + sizeof(digits);
+                do {
+                    *--p = static_cast<char>('0' + value % 10);
+                    value /= 10;
+                } while(value);
+                return write(p, digits + sizeof(digits) - p);
+            }
+
+            /**
+             * Writes the buffered text.
+             */
+            void flush()
+            {
+                writeAll(data, size);
+                size = 0;
+            }
+
+            /**
+             * @return true if a write failed, for instance on a closed pipe.
+             */
+            bool fail() const
+            {
+                return failed;
+            }
+
+            BufferedWriter(const BufferedWriter&) = delete;
+            BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+        private:
+            int fd;
+            size_t size;  // number of buffered characters
+            bool failed;
+            char data[CAPACITY];
+
+            void writeAll(const char *text, size_t length)
+            {
+                while(length && !failed) {
+                    ssize_t count = ::write(fd, text, length);
+                    if(count < 0 && errno == EINTR) continue;
+                    if(count <= 0) {
+                        failed = true;
+                        break;
+                    }
+                    text += count;
+                    length -= count;
+                }
+            }
+        };
+
+    }} // end namespaces
+
+#endif
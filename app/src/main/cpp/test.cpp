@@ -1,16 +1,56 @@
 #include "../../../gtest/googletest/googletest/include/gtest/gtest.h"
+#include "endgame_table.hpp"
 #include "hash_table.hpp"
+#include "opening_book.hpp"
+#include "position_record.hpp"
+#include "session_manager.hpp"
+#include "solver.hpp"
+#include "stream_io.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+
+using namespace GameSolver::Connect4;
+
+// Allocations of the test program, counted while countAllocations is set.
+// The replacements are not inlined, compilers would otherwise see free() called on memory of operator new
+static std::atomic<bool> countAllocations(false);
+static std::atomic<size_t> allocationCount(0);
+
+void *operator new(size_t size) {
+    if (countAllocations.load(std::memory_order_relaxed)) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void *memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+__attribute__((noinline)) void operator delete(void *memory, size_t) noexcept {
+    std::free(memory);
+}
 
 // Tests for TranspositionTable
 TEST(TranspositionTableTest, PutAndGet) {
-TranspositionTable transTable;
+TranspositionTable<> transTable;
 
 // Test put and get
-transTable.put(123, 42, false);
+transTable.put(123, 42);
 EXPECT_EQ(transTable.get(123), 42);
 
 // Test collisions and replacement
-transTable.put(123, 99, false);
+transTable.put(123, 99);
 EXPECT_EQ(transTable.get(123), 99);
 
 // Test key not found
@@ -18,23 +58,55 @@ EXPECT_EQ(transTable.get(456), 0);
 }
 
 TEST(TranspositionTableTest, CollisionRate) {
-TranspositionTable transTable;
+// A table of 64 entries counting its stats
+TranspositionTable<32, 8, 56, true> transTable(1024);
 
-// Insert some entries to generate collisions
+// Insert more entries than slots to generate collisions
 for (int i = 0; i < 200; ++i) {
-transTable.put(i, i % 10, false);
+transTable.put(i, i % 10);
 }
 
 // Test collision rate
 EXPECT_GT(transTable.getCollisionRate(), 0.0);
 }
 
+TEST(TranspositionTableTest, Stats) {
+TranspositionTable<32, 8, 56, true> transTable(1024);
+transTable.put(123, 42);
+transTable.put(123, 43);
+EXPECT_EQ(transTable.get(123), 43);
+EXPECT_EQ(transTable.get(456), 0);
+
+TranspositionTable<32, 8, 56, true>::Stats stats = transTable.getStats();
+EXPECT_EQ(stats.hits, 1u);
+EXPECT_EQ(stats.misses, 1u);
+EXPECT_EQ(stats.stores, 2u);
+EXPECT_EQ(stats.replacements, 0u);  // Updating the entry of the same key is not a collision
+EXPECT_EQ(stats.occupied, 1u);
+EXPECT_EQ(stats.size, transTable.getSize());
+EXPECT_DOUBLE_EQ(stats.hitRate(), 0.5);
+EXPECT_DOUBLE_EQ(stats.meanProbeLength(), 1.0);
+
+// Entries of older generations neither count as occupied nor as replaced
+transTable.clear();
+transTable.put(456, 1);
+stats = transTable.getStats();
+EXPECT_EQ(stats.occupied, 1u);
+EXPECT_EQ(stats.replacements, 0u);
+
+// Without stats the counters compile away
+TranspositionTable<32, 8, 56, false> plainTable(1024);
+plainTable.put(123, 42);
+EXPECT_EQ(plainTable.get(123), 42);
+EXPECT_EQ(plainTable.getStats().hits, 0u);
+}
+
 TEST(TranspositionTableTest, Reset) {
-TranspositionTable transTable;
+TranspositionTable<> transTable;
 
 // Insert some entries
-transTable.put(123, 42, false);
-transTable.put(456, 99, false);
+transTable.put(123, 42);
+transTable.put(456, 99);
 
 // Reset the table
 transTable.reset();
@@ -47,6 +119,731 @@ EXPECT_EQ(transTable.get(456), 0);
 EXPECT_EQ(transTable.getCollisionRate(), 0.0);
 }
 
+TEST(TranspositionTableTest, Clear) {
+TranspositionTable<> transTable;
+transTable.put(123, 42);
+
+// Entries of previous generations read as missing
+transTable.clear();
+EXPECT_EQ(transTable.get(123), 0);
+
+// Entries stored after clearing are found, including after the generation counter wraps around
+for (int i = 0; i < 300; ++i) {
+transTable.put(456, i % 200 + 1);
+EXPECT_EQ(transTable.get(456), i % 200 + 1);
+transTable.clear();
+EXPECT_EQ(transTable.get(456), 0);
+}
+}
+
+TEST(TranspositionTableTest, MemoryBudget) {
+TranspositionTable<> transTable(1 << 20);
+
+// The table never exceeds its budget
+EXPECT_LE(transTable.getMemoryUsage(), 1u << 20);
+EXPECT_GT(transTable.getMemoryUsage(), 1u << 19);
+
+// The number of entries is a power of two
+EXPECT_EQ(transTable.getSize() & (transTable.getSize() - 1), 0u);
+}
+
+TEST(TranspositionTableTest, FullTable) {
+TranspositionTable<> transTable(64);
+
+// Storing far more keys than slots never blocks, the latest key always wins its slot
+for (uint64_t key = 1; key <= 10000; ++key) {
+transTable.put(key, key % 200 + 1);
+EXPECT_EQ(transTable.get(key), key % 200 + 1);
+}
+}
+
+TEST(TranspositionTableTest, PartialKeys) {
+// 8 bits partial keys of 16 bits keys in a 512 entries table of 3 bytes entries, 16 entries per 64 bytes bucket
+TranspositionTable<8, 8, 16> transTable(2048);
+EXPECT_EQ(transTable.getSize(), 512u);
+EXPECT_EQ(transTable.getMemoryUsage(), 2048u);
+
+// Partial keys and slots together identify keys exactly
+transTable.put(1000, 7);
+for (uint64_t key = 0; key < (1 << 16); ++key) {
+EXPECT_EQ(transTable.get(key), key == 1000 ? 7 : 0);
+}
+}
+
+TEST(TranspositionTableTest, CallerMemory) {
+// Buckets start at the first cache line of the memory, the table stays within it
+alignas(64) static char arena[4096 + 64];
+TranspositionTable<> transTable(4096, arena + 8);
+EXPECT_EQ(transTable.getSize(), 256u);
+EXPECT_LE(transTable.getMemoryUsage(), 4096u);
+EXPECT_EQ(transTable.get(123), 0);
+transTable.put(123, 45);
+EXPECT_EQ(transTable.get(123), 45);
+
+// Memory that cannot hold a bucket is refused
+EXPECT_THROW((TranspositionTable<>(64, arena + 8)), std::bad_alloc);
+}
+
+TEST(TranspositionTableTest, SaveAndLoad) {
+TranspositionTable<> transTable(1024);
+transTable.put(123, 42);
+transTable.put(456, 99);
+transTable.clear();
+transTable.put(789, 7);
+ASSERT_TRUE(transTable.save("transposition_table_test.tt", 5));
+
+// Only the entries of the current generation are saved
+TranspositionTable<> loaded(1024);
+loaded.put(1000, 1);
+ASSERT_TRUE(loaded.load("transposition_table_test.tt", 5));
+EXPECT_EQ(loaded.get(789), 7);
+EXPECT_EQ(loaded.get(123), 0);
+EXPECT_EQ(loaded.get(1000), 0);
+
+// Tables of another size or format are not loaded
+TranspositionTable<> larger(2048);
+larger.put(1000, 1);
+EXPECT_FALSE(larger.load("transposition_table_test.tt", 5));
+EXPECT_EQ(larger.get(1000), 1);
+EXPECT_FALSE(loaded.load("transposition_table_test.tt", 6));
+EXPECT_FALSE(loaded.load("missing_transposition_table_test.tt", 5));
+
+// A mapped snapshot answers the keys the table misses, the table's own entries come first
+TranspositionTable<> mapped(1024);
+ASSERT_TRUE(mapped.mapSnapshot("transposition_table_test.tt", 5));
+EXPECT_EQ(mapped.get(789), 7);
+mapped.put(789, 8);
+EXPECT_EQ(mapped.get(789), 8);
+mapped.clear();
+EXPECT_EQ(mapped.get(789), 7);
+mapped.unmapSnapshot();
+EXPECT_EQ(mapped.get(789), 0);
+std::remove("transposition_table_test.tt");
+}
+
+// Tests for Position
+TEST(PositionTest, MirrorKey) {
+Position position;
+position.play("1123457");
+Position mirror;
+mirror.play("7765431");
+
+// The incrementally maintained mirror matches the position played on mirrored columns
+EXPECT_EQ(position.mirrorKey(), mirror.key());
+EXPECT_EQ(mirror.mirrorKey(), position.key());
+EXPECT_NE(position.key(), mirror.key());
+EXPECT_EQ(position.canonicalKey(), mirror.canonicalKey());
+
+// Symmetric positions are their own mirror
+Position symmetric;
+symmetric.play("4444");
+EXPECT_EQ(symmetric.mirrorKey(), symmetric.key());
+
+// Keys after a move are computed without playing it
+for (int col = 0; col < Position::WIDTH; col++) {
+Position next(position);
+next.play(col);
+EXPECT_EQ(position.canonicalKeyAfter(col), next.canonicalKey());
+}
+}
+
+TEST(PositionTest, PlayAndUndo) {
+Position position;
+position.play("4453");
+Position before(position);
+
+// Undoing restores the keys and the threats of both players
+position.play(5);
+position.play(5);
+EXPECT_TRUE(position.canWinNext());
+position.undo(5);
+position.undo(5);
+EXPECT_EQ(position.key(), before.key());
+EXPECT_EQ(position.mirrorKey(), before.mirrorKey());
+EXPECT_EQ(position.nbMoves(), before.nbMoves());
+EXPECT_EQ(position.winningPosition(), before.winningPosition());
+EXPECT_EQ(position.opponentWinningPosition(), before.opponentWinningPosition());
+EXPECT_FALSE(position.canWinNext());
+}
+
+TEST(PositionTest, Evaluate) {
+// Nothing favors a player at the beginning of the game
+Position position;
+EXPECT_EQ(position.evaluate(), 0);
+
+// Three empty cells complete an alignment for the current player, who wins
+position.play("2464337262467");
+ASSERT_FALSE(position.canWinNext());
+ASSERT_NE(position.possibleNonLosingMoves(), 0u);
+EXPECT_GT(position.evaluate(), 0);
+EXPECT_LE(position.evaluate(), (Position::WIDTH * Position::HEIGHT - 1 - 13) / 2);
+
+// The estimate does not depend on the side of the board
+Position mirror;
+mirror.play("6424553626421");
+EXPECT_EQ(mirror.evaluate(), position.evaluate());
+
+// Searches stopped by the depth limit take the estimate
+Connect4Solver solver(std::chrono::steady_clock::duration::max(), 0, Connect4Solver::NULL_WINDOW);
+EXPECT_EQ(solver.solve(position), position.evaluate());
+}
+
+#ifdef __SIZEOF_INT128__
+TEST(PositionTest, WideBoard) {
+// 9x7 bitboards take 72 bits, the 7th to 9th columns straddle the 64th bit
+typedef BasicPosition<9, 7> WidePosition;
+WidePosition position;
+ASSERT_EQ(position.play("617182"), 6u);
+
+// The bottom row of the 6th to 8th columns is completed on both sides
+EXPECT_TRUE(position.canWinNext());
+EXPECT_TRUE(position.isWinningMove(4));
+EXPECT_TRUE(position.isWinningMove(8));
+EXPECT_FALSE(position.isWinningMove(0));
+
+WidePosition mirror;
+mirror.play("493928");
+EXPECT_TRUE(position.mirrorKey() == mirror.key());
+EXPECT_TRUE(position.canonicalKey() == mirror.canonicalKey());
+
+position.undo(1);
+EXPECT_FALSE(position.canWinNext());
+}
+#endif
+
+// Tests for OpeningBook
+TEST(OpeningBookTest, WriteAndGet) {
+Position position;
+position.play("4453");
+Position mirror;
+mirror.play("4435");
+Position missing;
+missing.play("4454");
+
+std::vector<uint64_t> entries;
+entries.push_back(OpeningBook::packEntry(position.canonicalKey(), -3));
+entries.push_back(OpeningBook::packEntry(Position().canonicalKey(), 1));
+ASSERT_TRUE(OpeningBook::write("opening_book_test.book", entries, 4));
+
+OpeningBook book;
+ASSERT_TRUE(book.open("opening_book_test.book"));
+EXPECT_EQ(book.size(), 2u);
+EXPECT_EQ(book.getMaxPlies(), 4u);
+
+// Positions and their mirrors share entries
+int score = 0;
+EXPECT_TRUE(book.get(position, score));
+EXPECT_EQ(score, -3);
+EXPECT_TRUE(book.get(mirror, score));
+EXPECT_EQ(score, -3);
+EXPECT_TRUE(book.get(Position(), score));
+EXPECT_EQ(score, 1);
+EXPECT_FALSE(book.get(missing, score));
+
+book.close();
+EXPECT_FALSE(book.get(position, score));
+std::remove("opening_book_test.book");
+}
+
+TEST(OpeningBookTest, MisalignedAsset) {
+Position position;
+position.play("4453");
+std::vector<uint64_t> entries;
+for (int i = 0; i < 100; i++) {
+entries.push_back(OpeningBook::packEntry(i, i % 19 - 9));
+}
+entries.push_back(OpeningBook::packEntry(position.canonicalKey(), -3));
+ASSERT_TRUE(OpeningBook::write("opening_book_test.book", entries, 4));
+
+// Uncompressed assets of an APK are only aligned on 4 bytes
+std::string book;
+FILE *file = std::fopen("opening_book_test.book", "rb");
+ASSERT_TRUE(file != nullptr);
+char buffer[4096];
+size_t count;
+while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+book.append(buffer, count);
+}
+std::fclose(file);
+std::string apk = "APK!" + book + "tail";
+file = std::fopen("opening_book_test.apk", "wb");
+ASSERT_TRUE(file != nullptr);
+ASSERT_EQ(std::fwrite(apk.data(), 1, apk.size(), file), apk.size());
+ASSERT_EQ(std::fclose(file), 0);
+
+int fd = open("opening_book_test.apk", O_RDONLY);
+ASSERT_GE(fd, 0);
+OpeningBook asset;
+ASSERT_TRUE(asset.open(fd, 4, book.size()));
+close(fd);
+EXPECT_EQ(asset.size(), 101u);
+int score = 0;
+EXPECT_TRUE(asset.get(position, score));
+EXPECT_EQ(score, -3);
+Position missing;
+missing.play("4454");
+EXPECT_FALSE(asset.get(missing, score));
+std::remove("opening_book_test.book");
+std::remove("opening_book_test.apk");
+}
+
+// Tests for EndgameTable
+TEST(EndgameTableTest, WriteAndGet) {
+Position position;
+position.play("16473274736636175654744514513763");
+Position mirror;
+mirror.play("72415614152252713234144374375125");
+Position earlier;
+earlier.play("1647327473663617565474451451376");
+
+// The position scores 2, the table gets another score to check that the search uses it
+std::vector<std::vector<uint64_t>> levels(3);
+levels[2].push_back(OpeningBook::packEntry(position.canonicalKey(), -3));
+levels[0].push_back(OpeningBook::packEntry(Position().canonicalKey(), 1));
+ASSERT_TRUE(EndgameTable::write("endgame_table_test.table", levels, 30));
+
+EndgameTable table;
+ASSERT_TRUE(table.open("endgame_table_test.table"));
+EXPECT_EQ(table.size(), 2u);
+EXPECT_EQ(table.getMinMoves(), 30u);
+
+// Positions and their mirrors share entries, positions with fewer moves are not in the table
+int score = 0;
+EXPECT_TRUE(table.get(position, score));
+EXPECT_EQ(score, -3);
+EXPECT_TRUE(table.get(mirror, score));
+EXPECT_EQ(score, -3);
+EXPECT_FALSE(table.get(earlier, score));
+
+// The search stops at the positions of the table
+Connect4Solver solver;
+EXPECT_EQ(solver.solve(position), 2);
+solver.clearCache();
+solver.setEndgameTable(&table);
+EXPECT_EQ(solver.solve(position), -3);
+
+table.close();
+EXPECT_FALSE(table.get(position, score));
+std::remove("endgame_table_test.table");
+}
+
+// Tests for LineReader
+static std::vector<std::string> readLines(int fd) {
+LineReader reader(fd);
+std::vector<std::string> lines;
+const char *line;
+size_t length;
+while (reader.next(line, length)) {
+lines.push_back(std::string(line, length));
+}
+return lines;
+}
+
+TEST(LineReaderTest, RegularFile) {
+FILE *file = std::fopen("line_reader_test.txt", "wb");
+ASSERT_TRUE(file != nullptr);
+std::fputs("4453\n\n1234567", file);
+std::fclose(file);
+
+// Lines point into the mapping of the file, the last one has no '\n'
+int fd = open("line_reader_test.txt", O_RDONLY);
+ASSERT_GE(fd, 0);
+std::vector<std::string> lines = readLines(fd);
+close(fd);
+ASSERT_EQ(lines.size(), 3u);
+EXPECT_EQ(lines[0], "4453");
+EXPECT_EQ(lines[1], "");
+EXPECT_EQ(lines[2], "1234567");
+std::remove("line_reader_test.txt");
+}
+
+TEST(LineReaderTest, Pipe) {
+int fds[2];
+ASSERT_EQ(pipe(fds), 0);
+
+// A line longer than a block spans several reads
+std::string longLine(LineReader::BLOCK_SIZE + 10, '4');
+std::thread writer([&fds, &longLine] {
+for (const std::string &text : {std::string("12\n"), longLine, std::string("\n34\n")}) {
+EXPECT_EQ(write(fds[1], text.data(), text.size()), static_cast<ssize_t>(text.size()));
+}
+close(fds[1]);
+});
+std::vector<std::string> lines = readLines(fds[0]);
+writer.join();
+close(fds[0]);
+ASSERT_EQ(lines.size(), 3u);
+EXPECT_EQ(lines[0], "12");
+EXPECT_EQ(lines[1], longLine);
+EXPECT_EQ(lines[2], "34");
+}
+
+// Tests for PositionRecord
+TEST(PositionRecordTest, SetKey) {
+Position position;
+position.play("44455554221");
+
+// The key alone restores the position, its mirror and its threats
+Position decoded;
+ASSERT_TRUE(decoded.setKey(position.key()));
+EXPECT_EQ(decoded.key(), position.key());
+EXPECT_EQ(decoded.mirrorKey(), position.mirrorKey());
+EXPECT_EQ(decoded.nbMoves(), position.nbMoves());
+EXPECT_EQ(decoded.winningPosition(), position.winningPosition());
+EXPECT_EQ(decoded.opponentWinningPosition(), position.opponentWinningPosition());
+
+// Any order of the moves found from the key replays to the same position
+std::string moves;
+ASSERT_TRUE(decoded.moveSequence(moves));
+EXPECT_EQ(moves.size(), position.nbMoves());
+Position replayed;
+ASSERT_EQ(replayed.play(moves), moves.size());
+EXPECT_EQ(replayed.key(), position.key());
+
+// Overfull columns, wrong stone counts and alignments are rejected
+Position aligned;
+aligned.play("121212");
+aligned.play(0);
+EXPECT_FALSE(decoded.setKey(aligned.key()));
+EXPECT_FALSE(decoded.setKey(Position::bitboard_t(6)));
+EXPECT_FALSE(decoded.setKey(Position::bitboard_t((1 << (Position::HEIGHT + 1)) - 1)));
+EXPECT_FALSE(decoded.setKey(Position::bitboard_t(3)));
+EXPECT_EQ(decoded.key(), position.key());
+}
+
+TEST(PositionRecordTest, UnreachablePosition) {
+// Records of positions without alignment that no game reaches, the stones of the players cannot alternate
+PositionRecord<Position> record;
+ASSERT_TRUE(record.unpack(UINT64_C(0x124ad9004ce9d) | UINT64_C(28) << 49));
+
+// Their move sequences fail at once rather than after trying every order of the moves
+auto start = std::chrono::steady_clock::now();
+std::string moves;
+EXPECT_FALSE(record.position.moveSequence(moves));
+EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST(PositionRecordTest, ScoreRange) {
+Position position;
+position.play("4453");
+
+// Boundary scores round trip
+for (int score : {Position::MIN_SCORE, Position::MAX_SCORE}) {
+PositionRecord<Position> read;
+ASSERT_TRUE(read.unpack(PositionRecord<Position>(position, score, 3).pack()));
+EXPECT_EQ(read.score, score);
+EXPECT_EQ(read.bestMove, 3);
+}
+
+// Scores out of range, such as the estimates of interrupted searches, are packed as missing and leave the best move alone
+for (int score : {Position::MIN_SCORE - 3, Position::MAX_SCORE + 1, -100, 1000}) {
+uint64_t packed = PositionRecord<Position>(position, score, 3).pack();
+EXPECT_EQ(packed >> 61, 4u);
+PositionRecord<Position> read;
+ASSERT_TRUE(read.unpack(packed));
+EXPECT_EQ(read.score, PositionRecord<Position>::NO_SCORE);
+EXPECT_EQ(read.bestMove, 3);
+}
+EXPECT_EQ(PositionRecord<Position>(position, 0, Position::WIDTH).pack() >> 61, 0u);
+}
+
+TEST(PositionRecordTest, WriteAndRead) {
+Position position;
+position.play("4453");
+Position other;
+other.play("12");
+PositionRecord<Position> records[] = {{position, 5, 2}, {other}, {Position(), Position::MIN_SCORE, 6}};
+
+// Scores and best moves are optional
+{
+int fd = open("position_record_test.bin", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+ASSERT_GE(fd, 0);
+BufferedWriter output(fd);
+PositionRecordWriter<Position> writer(output);
+for (const PositionRecord<Position> &record : records) {
+writer.write(record);
+}
+output.flush();
+EXPECT_FALSE(output.fail());
+close(fd);
+}
+
+int fd = open("position_record_test.bin", O_RDONLY);
+ASSERT_GE(fd, 0);
+PositionRecordReader<Position> reader(fd);
+ASSERT_TRUE(reader.isValid());
+uint64_t packed;
+for (const PositionRecord<Position> &record : records) {
+ASSERT_TRUE(reader.next(packed));
+PositionRecord<Position> read;
+ASSERT_TRUE(read.unpack(packed));
+EXPECT_EQ(read.position.key(), record.position.key());
+EXPECT_EQ(read.score, record.score);
+EXPECT_EQ(read.bestMove, record.bestMove);
+}
+EXPECT_FALSE(reader.next(packed));
+close(fd);
+
+// Files of other boards are not read
+fd = open("position_record_test.bin", O_RDONLY);
+ASSERT_GE(fd, 0);
+PositionRecordReader<BasicPosition<6, 5>> otherReader(fd);
+EXPECT_FALSE(otherReader.isValid());
+EXPECT_FALSE(otherReader.next(packed));
+close(fd);
+std::remove("position_record_test.bin");
+
+// 8 bytes per record, the key of the 8x7 board does not fit
+EXPECT_TRUE(PositionRecord<Position>::SUPPORTED);
+EXPECT_FALSE((PositionRecord<BasicPosition<8, 7>>::SUPPORTED));
+}
+
+// Tests for Connect4Solver
+TEST(SolverTest, AnalyzeWinningMove) {
+Position position;
+position.play("555555112233");
+
+Connect4Solver solver;
+Connect4Solver::Analysis analysis = solver.analyze(position);
+
+// The fourth column completes the bottom row
+EXPECT_EQ(analysis.bestMove, 3);
+EXPECT_EQ(analysis.score, (Position::WIDTH * Position::HEIGHT + 1 - 12) / 2);
+EXPECT_EQ(analysis.columnScores[3], analysis.score);
+EXPECT_TRUE(analysis.exact);
+ASSERT_EQ(analysis.principalVariationLength, 1);
+EXPECT_EQ(analysis.principalVariation[0], 3);
+
+// Full columns have no score
+EXPECT_EQ(analysis.columnScores[4], Connect4Solver::INVALID_SCORE);
+EXPECT_EQ(solver.bestMove(position), 3);
+}
+
+TEST(SolverTest, IterativeDeepening) {
+Position position;
+position.play("2367343151161646");
+
+// Aspiration windows and the moves of earlier iterations only change the cost of the search
+Connect4Solver iterativeSolver(std::chrono::steady_clock::duration::max(), std::numeric_limits<int>::max(), Connect4Solver::ITERATIVE_DEEPENING);
+Connect4Solver nullWindowSolver(std::chrono::steady_clock::duration::max(), std::numeric_limits<int>::max(), Connect4Solver::NULL_WINDOW);
+EXPECT_EQ(iterativeSolver.solve(position), -1);
+EXPECT_EQ(nullWindowSolver.solve(position), -1);
+
+// The search of the position after the best move reuses the results of the first search
+position.play(5);
+EXPECT_EQ(iterativeSolver.solve(position), 1);
+}
+
+TEST(SolverTest, SavedCache) {
+Position position;
+position.play("2367343151161646");
+Connect4Solver solver;
+EXPECT_EQ(solver.solve(position), -1);
+unsigned long long coldNodes = solver.getExploredNodeCount();
+ASSERT_TRUE(solver.saveCache("solver_cache_test.tt"));
+
+// Solvers of a later process start with the results of the saved searches, copied or mapped
+Connect4Solver loaded;
+ASSERT_TRUE(loaded.loadCache("solver_cache_test.tt"));
+EXPECT_EQ(loaded.solve(position), -1);
+EXPECT_LT(loaded.getExploredNodeCount() * 100, coldNodes);
+Connect4Solver mapped;
+ASSERT_TRUE(mapped.mapCache("solver_cache_test.tt"));
+EXPECT_EQ(mapped.solve(position), -1);
+EXPECT_LT(mapped.getExploredNodeCount() * 100, coldNodes);
+
+// Caches of another board are not loaded
+BasicSolver<BasicPosition<6, 5>> otherBoard;
+EXPECT_FALSE(otherBoard.loadCache("solver_cache_test.tt"));
+std::remove("solver_cache_test.tt");
+}
+
+TEST(SolverTest, SearchStats) {
+Position position;
+position.play("2367343151161646");
+
+// Iterative deepening records one iteration per depth, whose nodes add up to the nodes of the search
+Connect4Solver solver;
+Connect4Solver::SearchStats stats;
+EXPECT_EQ(solver.solve(position, &stats), -1);
+ASSERT_EQ(stats.iterationCount, Position::WIDTH * Position::HEIGHT - 16);
+unsigned long long iterationNodes = 0;
+for (int i = 0; i < stats.iterationCount; i++) {
+EXPECT_EQ(stats.iterations[i].depth, i + 1);
+EXPECT_TRUE(stats.iterations[i].completed);
+iterationNodes += stats.iterations[i].nodeCount;
+}
+EXPECT_EQ(stats.iterations[stats.iterationCount - 1].score, -1);
+EXPECT_EQ(iterationNodes, stats.nodeCount);
+EXPECT_EQ(stats.nodeCount, solver.getExploredNodeCount());
+EXPECT_GT(stats.effectiveBranchingFactor(), 0.0);
+if (Connect4Solver::SearchStats::COUNTED) {
+EXPECT_GT(stats.cutoffCount(), 0u);
+EXPECT_GT(stats.firstMoveCutoffRate(), 0.5);  // The move ordering mostly finds the refutation first
+EXPECT_LE(stats.ttHits, stats.ttProbes);
+EXPECT_LE(stats.ttCutoffs, stats.ttHits);
+}
+
+// Null window searches all have the same depth
+Connect4Solver nullWindowSolver(std::chrono::steady_clock::duration::max(), std::numeric_limits<int>::max(), Connect4Solver::NULL_WINDOW);
+EXPECT_EQ(nullWindowSolver.solve(position, &stats), -1);
+EXPECT_GT(stats.iterationCount, 1);
+EXPECT_EQ(stats.iterations[0].depth, stats.iterations[stats.iterationCount - 1].depth);
+EXPECT_EQ(stats.effectiveBranchingFactor(), 0.0);
+}
+
+TEST(SolverTest, Interrupted) {
+// Searches cancelled before their result give estimates within the scores of the board, and tell it
+std::atomic<bool> cancelled(true);
+Position empty;
+for (Connect4Solver::SearchMode mode : {Connect4Solver::NULL_WINDOW, Connect4Solver::ITERATIVE_DEEPENING}) {
+Connect4Solver solver(std::chrono::steady_clock::duration::max(), std::numeric_limits<int>::max(), mode);
+solver.setCancelFlag(&cancelled);
+Connect4Solver::SearchStats stats;
+int score = solver.solve(empty, &stats);
+EXPECT_TRUE(solver.wasInterrupted());
+EXPECT_TRUE(stats.interrupted);
+EXPECT_GE(score, Position::MIN_SCORE);
+EXPECT_LE(score, Position::MAX_SCORE);
+
+// Completed searches are exact
+solver.setCancelFlag(nullptr);
+Position position;
+position.play("2367343151161646");
+EXPECT_EQ(solver.solve(position), -1);
+EXPECT_FALSE(solver.wasInterrupted());
+}
+
+std::vector<char> interruptions;
+Connect4Solver batchSolver;
+batchSolver.setCancelFlag(&cancelled);
+batchSolver.solveBatch({empty}, nullptr, &interruptions);
+EXPECT_EQ(interruptions, std::vector<char>({1}));
+}
+
+TEST(SolverTest, DepthLimitedRoot) {
+// Depth limited results of the first moves are stored within the scores the TranspositionTable holds,
+// their bounds near the root are wider than the scores of the board
+for (int depthLimit = 1; depthLimit <= 8; depthLimit++) {
+for (Connect4Solver::SearchMode mode : {Connect4Solver::NULL_WINDOW, Connect4Solver::ITERATIVE_DEEPENING}) {
+Connect4Solver solver(std::chrono::steady_clock::duration::max(), depthLimit, mode);
+for (int column = -1; column < Position::WIDTH; column++) {
+Position position;
+if (column >= 0) {
+position.play(column);
+}
+EXPECT_GE(position.evaluate(), Position::MIN_SCORE);
+EXPECT_LE(position.evaluate(), Position::MAX_SCORE);
+int score = solver.solve(position);
+EXPECT_GE(score, Position::MIN_SCORE);
+EXPECT_LE(score, Position::MAX_SCORE);
+EXPECT_EQ(solver.solve(position), score);  // Read back from the TranspositionTable
+}
+}
+}
+}
+
+TEST(SolverTest, MemoryLimit) {
+Position position;
+position.play("2367343151161646");
+
+// The searches of a solver built on an arena only use the arena
+const size_t limit = 1 << 20;
+std::unique_ptr<char[]> arena(new char[limit]);
+Connect4Solver solver(std::chrono::steady_clock::duration::max(), std::numeric_limits<int>::max(),
+                      Connect4Solver::ITERATIVE_DEEPENING, limit, arena.get());
+EXPECT_LE(solver.getMemoryUsage(), limit);
+allocationCount = 0;
+countAllocations = true;
+int score = solver.solve(position);
+Connect4Solver::Analysis analysis = solver.analyze(position);
+countAllocations = false;
+EXPECT_EQ(score, -1);
+EXPECT_EQ(analysis.score, -1);
+EXPECT_EQ(allocationCount.load(), 0u);
+}
+
+// Tests for SessionManager
+static void playMoves(SessionManager &manager, SessionManager::GameId game, const char *moves) {
+for (; *moves; moves++) {
+ASSERT_TRUE(manager.play(game, *moves - '1'));
+}
+}
+
+TEST(SessionManagerTest, ServesGames) {
+SessionManager manager(2, 1 << 20);
+SessionManager::GameId winning = manager.openGame();
+playMoves(manager, winning, "555555112233");
+SessionManager::GameId losing = manager.openGame();
+playMoves(manager, losing, "2367343151161646");
+
+std::mutex mutex;
+std::vector<std::pair<SessionManager::GameId, Connect4Solver::Analysis>> results;
+SessionManager::Callback callback = [&](SessionManager::GameId game, const Connect4Solver::Analysis &analysis) {
+std::lock_guard<std::mutex> lock(mutex);
+results.emplace_back(game, analysis);
+};
+ASSERT_TRUE(manager.analyze(winning, SessionManager::INTERACTIVE, std::chrono::seconds(60), callback));
+ASSERT_TRUE(manager.analyze(losing, SessionManager::BACKGROUND, std::chrono::seconds(60), callback));
+manager.wait();
+
+ASSERT_EQ(results.size(), 2u);
+for (const std::pair<SessionManager::GameId, Connect4Solver::Analysis> &result : results) {
+EXPECT_TRUE(result.second.exact);
+if (result.first == winning) {
+EXPECT_EQ(result.second.bestMove, 3);
+EXPECT_EQ(result.second.score, (Position::WIDTH * Position::HEIGHT + 1 - 12) / 2);
+} else {
+EXPECT_EQ(result.first, losing);
+EXPECT_EQ(result.second.score, -1);
+}
+}
+
+// Games over and closed games cannot be analyzed, and games do not add to the memory of the searches
+size_t memoryUsage = manager.getMemoryUsage();
+EXPECT_LE(memoryUsage, 1u << 20);
+EXPECT_TRUE(manager.play(winning, 3));
+EXPECT_FALSE(manager.play(winning, 0));
+EXPECT_FALSE(manager.analyze(winning, SessionManager::INTERACTIVE, std::chrono::seconds(1), callback));
+manager.closeGame(losing);
+EXPECT_FALSE(manager.analyze(losing, SessionManager::INTERACTIVE, std::chrono::seconds(1), callback));
+for (int i = 0; i < 1000; i++) {
+manager.openGame();
+}
+EXPECT_EQ(manager.getGameCount(), 1001u);
+EXPECT_EQ(manager.getMemoryUsage(), memoryUsage);
+}
+
+TEST(SessionManagerTest, InteractiveFirst) {
+SessionManager manager(1, 1 << 20);
+SessionManager::GameId game = manager.openGame();
+
+std::mutex mutex;
+std::vector<int> order;
+auto record = [&](int tag) {
+return [&, tag](SessionManager::GameId, const Connect4Solver::Analysis &) {
+std::lock_guard<std::mutex> lock(mutex);
+order.push_back(tag);
+};
+};
+auto start = std::chrono::steady_clock::now();
+
+// A long background analysis of the empty board occupies the only worker
+ASSERT_TRUE(manager.analyze(game, SessionManager::BACKGROUND, std::chrono::seconds(30), record(0)));
+while (manager.getQueueLength() > 0) {
+std::this_thread::yield();
+}
+ASSERT_TRUE(manager.analyze(game, SessionManager::BACKGROUND, std::chrono::milliseconds(20), record(1)));
+ASSERT_TRUE(manager.analyze(game, SessionManager::BACKGROUND, std::chrono::milliseconds(20), record(2)));
+playMoves(manager, game, "555555112233");
+
+// The interactive request cancels the running background analysis and is served before the queued ones
+ASSERT_TRUE(manager.analyze(game, SessionManager::INTERACTIVE, std::chrono::seconds(30), record(3)));
+manager.wait();
+EXPECT_EQ(order, std::vector<int>({0, 3, 1, 2}));
+EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(10));
+}
+
 // You can add more tests as needed
 
 int main(int argc, char **argv) {
@@ -0,0 +1,163 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A fixed-size pool of threads running submitted tasks, with work stealing.
+ *
+ * Each worker has its own task queue. Tasks are spread over the queues in round-robin
+ * order; a worker runs the tasks of its own queue from the back and, once it is empty,
+ * steals tasks from the front of the other queues, so that workers stay busy even when
+ * task durations vary a lot, as solving times of Connect 4 positions do.
+ */
+class ThreadPool {
+private:
+    /**
+     * @brief Task queue of a worker thread.
+     */
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex stateMutex;
+    std::condition_variable wakeUp;  // Signaled when a task is submitted or the pool stops
+    std::condition_variable idle;    // Signaled when the last pending task completes
+    size_t queued;   // Number of tasks waiting in the queues
+    size_t pending;  // Number of submitted tasks not completed yet
+    bool stopping;
+    std::atomic<unsigned int> nextWorker;  // Queue receiving the next submitted task
+
+    /**
+     * @brief Takes a task from the queue of a worker, or steals one from another queue.
+     * @param self Index of the worker looking for a task.
+     * @param task Set to the task found.
+     * @return true if a task was found.
+     */
+    bool pop(unsigned int self, std::function<void()> &task) {
+        for (unsigned int i = 0; i < workers.size(); i++) {
+            Worker &worker = *workers[(self + i) % workers.size()];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (!worker.tasks.empty()) {
+                if (i == 0) {
+                    task = std::move(worker.tasks.back());
+                    worker.tasks.pop_back();
+                } else {
+                    task = std::move(worker.tasks.front());
+                    worker.tasks.pop_front();
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Main loop of a worker thread.
+     * @param self Index of the worker.
+     */
+    void run(unsigned int self) {
+        for (;;) {
+            std::function<void()> task;
+            if (pop(self, task)) {
+                {
+                    std::lock_guard<std::mutex> lock(stateMutex);
+                    queued--;
+                }
+                task();
+                std::lock_guard<std::mutex> lock(stateMutex);
+                if (--pending == 0) {
+                    idle.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(stateMutex);
+            wakeUp.wait(lock, [this] { return stopping || queued > 0; });
+            if (stopping && queued == 0) {
+                return;
+            }
+        }
+    }
+
+public:
+    /**
+     * @brief Starts the worker threads.
+     * @param threadCount Number of worker threads, at least 1.
+     */
+    explicit ThreadPool(unsigned int threadCount) : queued(0), pending(0), stopping(false), nextWorker(0) {
+        if (threadCount == 0) {
+            threadCount = 1;
+        }
+        for (unsigned int i = 0; i < threadCount; i++) {
+            workers.emplace_back(new Worker);
+        }
+        for (unsigned int i = 0; i < threadCount; i++) {
+            threads.emplace_back(&ThreadPool::run, this, i);
+        }
+    }
+
+    /**
+     * @brief Runs the remaining tasks and stops the worker threads.
+     */
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @return The number of worker threads.
+     */
+    size_t size() const {
+        return threads.size();
+    }
+
+    /**
+     * @brief Queues a task to be run by a worker thread.
+     * @param task The task, it must not throw.
+     */
+    void submit(std::function<void()> task) {
+        {
+            // Counted before being queued, so that a worker never sees more tasks than counted
+            std::lock_guard<std::mutex> lock(stateMutex);
+            queued++;
+            pending++;
+        }
+        Worker &worker = *workers[nextWorker++ % workers.size()];
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.tasks.push_back(std::move(task));
+        }
+        wakeUp.notify_one();
+    }
+
+    /**
+     * @brief Waits until all the submitted tasks are completed.
+     */
+    void wait() {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        idle.wait(lock, [this] { return pending == 0; });
+    }
+};
+
+#endif
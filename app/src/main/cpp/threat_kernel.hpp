@@ -0,0 +1,184 @@
+#ifndef THREAT_KERNEL_HPP
+#define THREAT_KERNEL_HPP
+
+#include <cstdint>
+#include <cstring>
+
+namespace GameSolver { namespace Connect4 {
+
+        /**
+         * Scores all the moves of a node at once for move ordering: for each column, counts the
+         * empty cells completing an alignment once the column is played.
+         *
+         * The alignment computation is a fixed sequence of whole board shifts with no branch, so
+         * it is written once for any type supporting shifts and bitwise operations, and is run on:
+         * - plain 64 bits integers, one column at a time
+         * - 128 bits vectors of 2 columns, SSE2 on x86-64 and NEON on ARM
+         * - 256 bits vectors of 4 columns, AVX2 on x86, with the POPCNT instruction
+         * Vector lanes are filled by broadcasting the player's stones and the playable cells, and
+         * masking each lane with the cells of its column. Vectors use the GCC and Clang vector
+         * extensions.
+         *
+         * The scalar variant is used by default: it only scores the playable columns, often a few
+         * once losing moves are pruned, and it is the fastest on the whole search. Defining
+         * CONNECT4_SIMD_THREATS selects at runtime the widest vector variant supported by the CPU.
+         *
+         * @tparam Width number of columns of the board.
+         * @tparam Height number of rows of the board, each column takes Height + 1 bits.
+         */
+        template<int Width, int Height>
+        class ThreatKernel {
+        public:
+            /**
+             * Signature of the kernel variants.
+             * @param position bitboard of the player's stones.
+             * @param moves bitboard of the playable cells to score, at most one per column.
+             * @param empty bitboard of the empty cells of the board, before playing the moves.
+             * @param scores set to the number of empty cells completing an alignment after playing each
+             *        column, for the Width columns. Scores of columns without a move are meaningless.
+             */
+            typedef void (*Function)(uint64_t position, uint64_t moves, uint64_t empty, int *scores);
+
+            /**
+             * @return the variant of the kernel selected for this build and CPU.
+             */
+            static Function get() {
+                static const Function function = select();
+                return function;
+            }
+
+            /**
+             * Computes the cells completing an alignment for a player, empty or not, with whole board
+             * shifts in each direction. Bits out of the board are not filtered.
+             * @param position bitboard of the player's stones, of 64 bits or more.
+             */
+            template<class Bitboard>
+            static Bitboard threats(Bitboard position) {
+                Bitboard r;
+                threats(position, r);
+                return r;
+            }
+
+            /**
+             * Same as threats(position) for a bitboard or a vector of bitboards.
+             * Vectors are passed by reference, AVX2 ones cannot be passed by value from code built without AVX.
+             */
+            template<class T>
+#if defined(__GNUC__)
+            __attribute__((always_inline))
+#endif
+            static inline void threats(const T &position, T &r) {
+                // vertical
+                r = (position << 1) & (position << 2) & (position << 3);
+
+                // horizontal
+                T p = (position << (Height + 1)) & (position << 2 * (Height + 1));
+                r |= p & (position << 3 * (Height + 1));
+                r |= p & (position >> (Height + 1));
+                p = (position >> (Height + 1)) & (position >> 2 * (Height + 1));
+                r |= p & (position << (Height + 1));
+                r |= p & (position >> 3 * (Height + 1));
+
+                // diagonal 1
+                p = (position << Height) & (position << 2 * Height);
+                r |= p & (position << 3 * Height);
+                r |= p & (position >> Height);
+                p = (position >> Height) & (position >> 2 * Height);
+                r |= p & (position << Height);
+                r |= p & (position >> 3 * Height);
+
+                // diagonal 2
+                p = (position << (Height + 2)) & (position << 2 * (Height + 2));
+                r |= p & (position << 3 * (Height + 2));
+                r |= p & (position >> (Height + 2));
+                p = (position >> (Height + 2)) & (position >> 2 * (Height + 2));
+                r |= p & (position << (Height + 2));
+                r |= p & (position >> 3 * (Height + 2));
+            }
+
+            static void scalar(uint64_t position, uint64_t moves, uint64_t empty, int *scores) {
+                for (int col = 0; col < Width; col++) {
+                    uint64_t move = moves & columnMask(col);
+                    if (move) {
+                        scores[col] = popcount(threats(position | move) & empty);
+                    }
+                }
+            }
+
+#if defined(__GNUC__) && (defined(__SSE2__) || defined(__ARM_NEON))
+            static void vector2(uint64_t position, uint64_t moves, uint64_t empty, int *scores) {
+                lanes<u64x2>(position, moves, empty, scores);
+            }
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+            __attribute__((target("avx2,popcnt")))
+            static void vector4(uint64_t position, uint64_t moves, uint64_t empty, int *scores) {
+                lanes<u64x4>(position, moves, empty, scores);
+            }
+#endif
+
+        private:
+#if defined(__GNUC__)
+            typedef uint64_t u64x2 __attribute__((vector_size(16)));
+            typedef uint64_t u64x4 __attribute__((vector_size(32)));
+
+            /**
+             * Runs the kernel on vectors of columns, lane j of the i-th vector holding column i * LANES + j.
+             */
+            template<class V>
+            __attribute__((always_inline))
+            static inline void lanes(uint64_t position, uint64_t moves, uint64_t empty, int *scores) {
+                const int LANES = sizeof(V) / sizeof(uint64_t);
+                for (int i = 0; i < Width; i += LANES) {
+                    uint64_t columns[LANES];
+                    for (int j = 0; j < LANES; j++) {
+                        columns[j] = i + j < Width ? columnMask(i + j) : 0;  // constants once unrolled
+                    }
+                    V v;
+                    std::memcpy(&v, columns, sizeof(V));
+                    v = (v & moves) | position;
+                    V r;
+                    threats(v, r);
+                    r &= empty;
+                    uint64_t out[LANES];
+                    std::memcpy(out, &r, sizeof(V));
+                    for (int j = 0; j < LANES && i + j < Width; j++) {
+                        scores[i + j] = popcount(out[j]);
+                    }
+                }
+            }
+#endif
+
+            static uint64_t columnMask(int col) {
+                return ((UINT64_C(1) << Height) - 1) << col * (Height + 1);
+            }
+
+            static int popcount(uint64_t m) {
+#if defined(__GNUC__)
+                return __builtin_popcountll(m);
+#else
+                int c = 0;
+                for(; m; c++) m &= m - 1;
+                return c;
+#endif
+            }
+
+            static Function select() {
+#if defined(CONNECT4_SIMD_THREATS)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+                if (__builtin_cpu_supports("avx2")) {
+                    return vector4;
+                }
+#endif
+#if defined(__GNUC__) && (defined(__SSE2__) || defined(__ARM_NEON))
+                return vector2;
+#endif
+#endif
+                return scalar;
+            }
+        };
+
+    }} // end namespaces
+
+#endif
@@ -0,0 +1,159 @@
+package com.example.connect4
+
+import android.content.res.AssetManager
+import android.os.Handler
+import android.os.Looper
+import java.io.File
+import java.io.IOException
+
+/**
+ * Connect 4 engine running in native code.
+ *
+ * The engine holds the current game natively, moves are sent one at a time and the board never
+ * crosses the JNI boundary. Its solver lives as long as the engine, so that the results of the
+ * searches of a move speed up the searches of the following ones.
+ *
+ * Searches run on a native worker thread and report to their listener on the main thread.
+ * Columns are numbered from 0 for the leftmost one.
+ */
+class Connect4Engine : AutoCloseable {
+
+    /**
+     * Result of a completed iteration of a search.
+     * @property depth Number of moves searched ahead.
+     * @property score Score of the position for the player to move.
+     * @property bestMove Column of the best move.
+     * @property exact Whether the scores are exact rather than estimated at a limited depth.
+     * @property columnScores Score of playing each column, [INVALID_SCORE] for full columns.
+     * @property principalVariation Expected moves, starting with [bestMove].
+     */
+    class Analysis(
+        val depth: Int,
+        val score: Int,
+        val bestMove: Int,
+        val exact: Boolean,
+        val columnScores: IntArray,
+        val principalVariation: IntArray
+    )
+
+    interface Listener {
+        /** Called after each completed iteration of the search. */
+        fun onProgress(analysis: Analysis) {}
+
+        /** Called once the search completes, runs out of time or is cancelled. */
+        fun onResult(analysis: Analysis)
+    }
+
+    private var handle: Long = nativeCreate()
+    private val mainHandler = Handler(Looper.getMainLooper())
+
+    /** Number of moves played in the current game. */
+    val moveCount: Int
+        get() = nativeGetMoveCount(handle)
+
+    /**
+     * Plays a move. Once a winning move is played, no other move can be played until [undo] or [newGame].
+     * @return false if the column is full or the game is over.
+     */
+    fun play(column: Int): Boolean = nativePlay(handle, column)
+
+    /**
+     * Takes back the last move.
+     * @return false if no move has been played.
+     */
+    fun undo(): Boolean = nativeUndo(handle)
+
+    fun newGame() = nativeNewGame(handle)
+
+    /** Tells whether playing a column wins the game. */
+    fun isWinningMove(column: Int): Boolean = nativeIsWinningMove(handle, column)
+
+    /**
+     * Opens the opening book stored as an uncompressed asset, to be called before the first search.
+     * @return false if the book cannot be opened.
+     */
+    fun loadOpeningBook(assets: AssetManager, name: String): Boolean = try {
+        assets.openFd(name).use { nativeOpenBook(handle, it.parcelFileDescriptor.fd, it.startOffset, it.length) }
+    } catch (e: IOException) {
+        false
+    }
+
+    /**
+     * Loads the results of the searches saved by [saveCache] in a previous session, to be called before the
+     * first search so that it starts with a warm transposition table. The file is read by the native worker
+     * thread before the following searches, the call returns at once. A missing file, or a file saved by
+     * another version of the engine, is ignored.
+     */
+    fun loadCache(file: File) = nativeLoadCache(handle, file.path)
+
+    /**
+     * Saves the results of the searches of the session for the next one. The file is written by the native
+     * worker thread once the running search completes, the call returns at once, and it is replaced once
+     * complete. A save still pending when the engine is closed is done by [close].
+     */
+    fun saveCache(file: File) = nativeSaveCache(handle, file.path)
+
+    /**
+     * Analyzes the current position, cancelling the running search if any.
+     * @param timeLimitMillis Time limit of the search.
+     * @return false if the game is over.
+     */
+    fun analyze(timeLimitMillis: Long, listener: Listener): Boolean =
+        nativeAnalyze(handle, timeLimitMillis, NativeListener(listener))
+
+    /**
+     * Cancels the running search, which reports the result of its last completed iteration.
+     */
+    fun cancel() = nativeCancel(handle)
+
+    override fun close() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    /**
+     * Receives the results of a search on the native worker thread.
+     */
+    private inner class NativeListener(private val listener: Listener) {
+        @Suppress("unused") // Called from native code
+        fun onAnalysis(
+            depth: Int, score: Int, bestMove: Int, exact: Boolean,
+            columnScores: IntArray, principalVariation: IntArray, done: Boolean
+        ) {
+            val analysis = Analysis(depth, score, bestMove, exact, columnScores, principalVariation)
+            mainHandler.post {
+                if (done) listener.onResult(analysis) else listener.onProgress(analysis)
+            }
+        }
+    }
+
+    private external fun nativeCreate(): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativePlay(handle: Long, column: Int): Boolean
+    private external fun nativeUndo(handle: Long): Boolean
+    private external fun nativeNewGame(handle: Long)
+    private external fun nativeGetMoveCount(handle: Long): Int
+    private external fun nativeIsWinningMove(handle: Long, column: Int): Boolean
+    private external fun nativeOpenBook(handle: Long, fd: Int, offset: Long, length: Long): Boolean
+    private external fun nativeLoadCache(handle: Long, path: String)
+    private external fun nativeSaveCache(handle: Long, path: String)
+    private external fun nativeAnalyze(handle: Long, timeLimitMillis: Long, listener: Any): Boolean
+    private external fun nativeCancel(handle: Long)
+
+    companion object {
+        /** Score of the columns that cannot be played. */
+        const val INVALID_SCORE = Int.MIN_VALUE
+
+        /** Name of the opening book asset. */
+        const val OPENING_BOOK = "opening.book"
+
+        /** Name of the file of the saved transposition table, in the cache directory of the app. */
+        const val CACHE_FILE = "connect4.tt"
+
+        init {
+            System.loadLibrary("connect4")
+        }
+    }
+}
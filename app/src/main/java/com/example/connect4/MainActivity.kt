@@ -11,10 +11,17 @@ import androidx.compose.runtime.Composable
 import androidx.compose.ui.Modifier
 import androidx.compose.ui.tooling.preview.Preview
 import com.example.connect4.ui.theme.Connect4Theme
+import java.io.File
 
 class MainActivity : ComponentActivity() {
+    // Lives as long as the activity so that its transposition table stays warm during the game
+    private lateinit var engine: Connect4Engine
+
     override fun onCreate(savedInstanceState: Bundle?) {
         super.onCreate(savedInstanceState)
+        engine = Connect4Engine()
+        engine.loadOpeningBook(assets, Connect4Engine.OPENING_BOOK)
+        engine.loadCache(File(cacheDir, Connect4Engine.CACHE_FILE))
         setContent {
             Connect4Theme {
                 // A surface container using the 'background' color from the theme
@@ -27,6 +34,18 @@ class MainActivity : ComponentActivity() {
             }
         }
     }
+
+    override fun onStop() {
+        // The process may be killed once stopped, the next launch starts from the results saved here.
+        // Loading and saving the cache run on the engine's worker thread, not on the main thread
+        engine.saveCache(File(cacheDir, Connect4Engine.CACHE_FILE))
+        super.onStop()
+    }
+
+    override fun onDestroy() {
+        engine.close()
+        super.onDestroy()
+    }
 }
 
 @Composable